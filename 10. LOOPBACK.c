@@ -0,0 +1,376 @@
+/* ########################## LOOPBACK — lpc17xx_loopback.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Number of samples in each ADC/DAC DMA block in FIR mode */
+#define LOOPBACK_BLOCK_SIZE		64
+/** Maximum number of FIR taps */
+#define LOOPBACK_MAX_TAPS		32
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief Loopback configuration structure */
+typedef struct {
+	uint32_t SampleRate;	/**< ADC conversion rate (Hz), should be <= 200KHz.
+							The DAC update rate is derived from the actual ADC rate */
+	uint8_t ADCChannel;		/**< ADC input channel, should be in range from 0 to 7 */
+	uint8_t ADCDMAChannel;	/**< DMA channel for ADC, should be in range from 0 to 7.
+							In direct mode this is the only channel used */
+	uint8_t DACDMAChannel;	/**< DMA channel for DAC (FIR mode only), should be in
+							range from 0 to 7 */
+	uint8_t NumTaps;		/**< Number of FIR taps (FIR mode only), should be in
+							range from 1 to LOOPBACK_MAX_TAPS */
+	const int16_t *Coeffs;	/**< FIR coefficients in Q15 (FIR mode only) */
+} LOOPBACK_CFG_Type;
+
+/* Private Variables ---------------------------------------------------------- */
+
+static struct {
+	uint32_t SampleRate;			/**< Actual ADC conversion rate (Hz) */
+	uint32_t LatencyNs;				/**< End-to-end latency (ns) */
+	uint8_t ADCChannel;
+	uint8_t ADCDMAChannel;
+	uint8_t DACDMAChannel;
+	uint8_t NumTaps;
+	uint8_t FIRMode;				/**< 0: direct P2P, 1: block FIR */
+	uint8_t Active;					/**< Index of the ADC block being filled */
+	__IO uint32_t Overruns;			/**< ADC blocks completed before the previous
+									one was processed */
+	int16_t Coeffs[LOOPBACK_MAX_TAPS];
+	int16_t History[LOOPBACK_MAX_TAPS - 1 + LOOPBACK_BLOCK_SIZE];
+} LOOPBACK;
+
+static uint32_t LOOPBACK_ADCBuffer[2][LOOPBACK_BLOCK_SIZE];
+static uint32_t LOOPBACK_DACBuffer[2][LOOPBACK_BLOCK_SIZE];
+static GPDMA_LLI_Type LOOPBACK_ADCLLI[2];
+static GPDMA_LLI_Type LOOPBACK_DACLLI[2];
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Common ADC/DAC setup for both modes
+ * 					- ADC in burst mode on a single channel, DMA request
+ * 					  on channel done, no NVIC interrupt
+ * 					- DAC counter reloaded at the actual ADC rate
+ * @param[in]	LoopbackCfg	Pointer to a LOOPBACK_CFG_Type structure
+ * @return 		ERROR if the ADC conversion time is not a whole number
+ * 				of DAC clocks or exceeds 0xFFFF DAC clocks, SUCCESS otherwise
+ **********************************************************************/
+static Status LOOPBACK_ConverterInit(LOOPBACK_CFG_Type *LoopbackCfg)
+{
+	DAC_CONVERTER_CFG_Type DACCfg;
+	uint32_t adcclk;
+	uint64_t dacticks;
+
+	ADC_Init(LPC_ADC, LoopbackCfg->SampleRate);
+	ADC_ChannelCmd(LPC_ADC, LoopbackCfg->ADCChannel, ENABLE);
+	/* Channel done raises the DMA request, global flag must be off in burst mode */
+	ADC_IntConfig(LPC_ADC, (ADC_TYPE_INT_OPT)LoopbackCfg->ADCChannel, ENABLE);
+	ADC_IntConfig(LPC_ADC, ADC_ADGINTEN, DISABLE);
+
+	/* A conversion takes 65 ADC clocks, ADC clock = PCLK / (CLKDIV + 1) */
+	adcclk = ((LPC_ADC->ADCR >> 8) & 0xFF) + 1;
+	LOOPBACK.SampleRate = CLKPWR_GetPCLK(CLKPWR_PCLKSEL_ADC) / (adcclk * 65);
+	/* The DAC runs free from the ADC, so its period must match exactly or
+	 * it drifts into the block being filtered */
+	dacticks = (uint64_t)CLKPWR_GetPCLK(CLKPWR_PCLKSEL_DAC) * adcclk * 65;
+	if ((dacticks % CLKPWR_GetPCLK(CLKPWR_PCLKSEL_ADC)) != 0) {
+		return ERROR;
+	}
+	dacticks /= CLKPWR_GetPCLK(CLKPWR_PCLKSEL_ADC);
+	/* DAC counter reload is 16 bits */
+	if (dacticks > 0xFFFF) {
+		return ERROR;
+	}
+	DAC_SetDMATimeOut(LPC_DAC, (uint32_t)dacticks);
+	DACCfg.DBLBUF_ENA = 1;
+	DACCfg.CNT_ENA = 1;
+	DACCfg.DMA_ENA = 1;
+	DAC_ConfigDAConverterControl(LPC_DAC, &DACCfg);
+
+	LOOPBACK.ADCChannel = LoopbackCfg->ADCChannel;
+	LOOPBACK.ADCDMAChannel = LoopbackCfg->ADCDMAChannel;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Run the FIR on one ADC block and write DACR words
+ * @param[in]	in	ADC block, ADGDR words
+ * @param[in]	out	DAC block, DACR words
+ * @return 		None
+ **********************************************************************/
+static void LOOPBACK_FIRBlock(const uint32_t *in, uint32_t *out)
+{
+	int16_t *x = &LOOPBACK.History[LOOPBACK.NumTaps - 1];
+	const int16_t *h = LOOPBACK.Coeffs;
+	uint32_t i, k;
+	int32_t acc;
+
+	/* 12-bit unsigned result to signed */
+	for (i = 0; i < LOOPBACK_BLOCK_SIZE; i++) {
+		x[i] = (int16_t)ADC_DR_RESULT(in[i]) - 2048;
+	}
+
+	for (i = 0; i < LOOPBACK_BLOCK_SIZE; i++) {
+		acc = 0;
+		for (k = 0; k < LOOPBACK.NumTaps; k++) {
+			acc += h[k] * x[(int32_t)i - (int32_t)k];
+		}
+		/* Q15 back to 12 bits, then 12 bits to 10 bits unsigned */
+		acc = ((acc >> 15) >> 2) + 512;
+		if (acc < 0) {
+			acc = 0;
+		} else if (acc > 1023) {
+			acc = 1023;
+		}
+		out[i] = DAC_VALUE(acc);
+	}
+
+	/* Keep the last NumTaps - 1 samples for the next block */
+	for (k = 0; k < (uint32_t)(LOOPBACK.NumTaps - 1); k++) {
+		LOOPBACK.History[k] = x[LOOPBACK_BLOCK_SIZE - LOOPBACK.NumTaps + 1 + k];
+	}
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Initial direct ADC to DAC loopback
+ * 				A single GPDMA_TRANSFERTYPE_P2P channel copies ADGDR to
+ * 				DACR with no CPU involvement. ADGDR holds the result in
+ * 				bits 15:4 and DACR takes the value in bits 15:6, so the
+ * 				word copy hands the 10 most significant bits to the DAC.
+ * 				The linker list item points to itself to run forever.
+ * 				GPDMA_Init() must have been called before.
+ * @param[in]	LoopbackCfg	Pointer to a LOOPBACK_CFG_Type structure
+ * @return 		ERROR if the DMA channel is enabled before or the DAC
+ * 				clock cannot match the ADC rate, SUCCESS if loopback is
+ * 				configured successfully
+ **********************************************************************/
+Status LOOPBACK_DirectInit(LOOPBACK_CFG_Type *LoopbackCfg)
+{
+	GPDMA_Channel_CFG_Type GPDMACfg;
+
+	if (LOOPBACK_ConverterInit(LoopbackCfg) == ERROR) {
+		return ERROR;
+	}
+	LOOPBACK.FIRMode = 0;
+
+	LOOPBACK_ADCLLI[0].SrcAddr = (uint32_t)&(LPC_ADC->ADGDR);
+	LOOPBACK_ADCLLI[0].DstAddr = (uint32_t)&(LPC_DAC->DACR);
+	LOOPBACK_ADCLLI[0].NextLLI = (uint32_t)&LOOPBACK_ADCLLI[0];
+	LOOPBACK_ADCLLI[0].Control = GPDMA_DMACCxControl_TransferSize(0xFFF)
+			| GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_1)
+			| GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_1)
+			| GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD);
+
+	GPDMACfg.ChannelNum = LoopbackCfg->ADCDMAChannel;
+	GPDMACfg.SrcMemAddr = 0;
+	GPDMACfg.DstMemAddr = 0;
+	GPDMACfg.TransferSize = 0xFFF;
+	GPDMACfg.TransferWidth = 0;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_P2P;
+	GPDMACfg.SrcConn = GPDMA_CONN_ADC;
+	GPDMACfg.DstConn = GPDMA_CONN_DAC;
+	GPDMACfg.DMALLI = (uint32_t)&LOOPBACK_ADCLLI[0];
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+
+	/* Same burst in the first block as in the linker list */
+	GPDMA_Channel[LoopbackCfg->ADCDMAChannel]->DMACCControl = LOOPBACK_ADCLLI[0].Control;
+
+	/* One conversion, at most one DAC period waiting for the request and
+	 * one more until the double buffered DACR reaches AOUT */
+	LOOPBACK.LatencyNs = 3000000000UL / LOOPBACK.SampleRate;
+
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Initial block FIR loopback
+ * 				ADC fills two blocks through a circular linker list. On
+ * 				each terminal count, LOOPBACK_DMAHandler() filters the
+ * 				finished block into the DAC block that plays after the
+ * 				current one, so a sample leaves the DAC two blocks after
+ * 				it was converted, plus the FIR group delay.
+ * 				GPDMA_Init() must have been called before.
+ * @param[in]	LoopbackCfg	Pointer to a LOOPBACK_CFG_Type structure
+ * @return 		ERROR if a DMA channel is enabled before, NumTaps is out
+ * 				of range or the DAC clock cannot match the ADC rate,
+ * 				SUCCESS if loopback is configured successfully
+ **********************************************************************/
+Status LOOPBACK_FIRInit(LOOPBACK_CFG_Type *LoopbackCfg)
+{
+	GPDMA_Channel_CFG_Type GPDMACfg;
+	uint32_t i, control;
+
+	if ((LoopbackCfg->NumTaps == 0) || (LoopbackCfg->NumTaps > LOOPBACK_MAX_TAPS)) {
+		return ERROR;
+	}
+
+	if (LOOPBACK_ConverterInit(LoopbackCfg) == ERROR) {
+		return ERROR;
+	}
+	LOOPBACK.FIRMode = 1;
+	LOOPBACK.DACDMAChannel = LoopbackCfg->DACDMAChannel;
+	LOOPBACK.NumTaps = LoopbackCfg->NumTaps;
+	LOOPBACK.Active = 0;
+	LOOPBACK.Overruns = 0;
+	for (i = 0; i < LoopbackCfg->NumTaps; i++) {
+		LOOPBACK.Coeffs[i] = LoopbackCfg->Coeffs[i];
+	}
+	for (i = 0; i < LOOPBACK_MAX_TAPS - 1; i++) {
+		LOOPBACK.History[i] = 0;
+	}
+	for (i = 0; i < LOOPBACK_BLOCK_SIZE; i++) {
+		LOOPBACK_DACBuffer[0][i] = DAC_VALUE(512);
+		LOOPBACK_DACBuffer[1][i] = DAC_VALUE(512);
+	}
+
+	/* ADC: ADGDR -> block 0 -> block 1 -> block 0 ..., interrupt per block */
+	control = GPDMA_DMACCxControl_TransferSize(LOOPBACK_BLOCK_SIZE)
+			| GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_1)
+			| GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_1)
+			| GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_DI
+			| GPDMA_DMACCxControl_I;
+	LOOPBACK_ADCLLI[0].SrcAddr = (uint32_t)&(LPC_ADC->ADGDR);
+	LOOPBACK_ADCLLI[0].DstAddr = (uint32_t)LOOPBACK_ADCBuffer[1];
+	LOOPBACK_ADCLLI[0].NextLLI = (uint32_t)&LOOPBACK_ADCLLI[1];
+	LOOPBACK_ADCLLI[0].Control = control;
+	LOOPBACK_ADCLLI[1].SrcAddr = (uint32_t)&(LPC_ADC->ADGDR);
+	LOOPBACK_ADCLLI[1].DstAddr = (uint32_t)LOOPBACK_ADCBuffer[0];
+	LOOPBACK_ADCLLI[1].NextLLI = (uint32_t)&LOOPBACK_ADCLLI[0];
+	LOOPBACK_ADCLLI[1].Control = control;
+
+	GPDMACfg.ChannelNum = LoopbackCfg->ADCDMAChannel;
+	GPDMACfg.SrcMemAddr = 0;
+	GPDMACfg.DstMemAddr = (uint32_t)LOOPBACK_ADCBuffer[0];
+	GPDMACfg.TransferSize = LOOPBACK_BLOCK_SIZE;
+	GPDMACfg.TransferWidth = 0;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+	GPDMACfg.SrcConn = GPDMA_CONN_ADC;
+	GPDMACfg.DstConn = 0;
+	GPDMACfg.DMALLI = (uint32_t)&LOOPBACK_ADCLLI[0];
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+	/* Same burst in the first block as in the linker list */
+	GPDMA_Channel[LoopbackCfg->ADCDMAChannel]->DMACCControl = LOOPBACK_ADCLLI[1].Control;
+
+	/* DAC: block 0 -> block 1 -> block 0 ..., no interrupt */
+	control = GPDMA_DMACCxControl_TransferSize(LOOPBACK_BLOCK_SIZE)
+			| GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_1)
+			| GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_1)
+			| GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_SI;
+	LOOPBACK_DACLLI[0].SrcAddr = (uint32_t)LOOPBACK_DACBuffer[1];
+	LOOPBACK_DACLLI[0].DstAddr = (uint32_t)&(LPC_DAC->DACR);
+	LOOPBACK_DACLLI[0].NextLLI = (uint32_t)&LOOPBACK_DACLLI[1];
+	LOOPBACK_DACLLI[0].Control = control;
+	LOOPBACK_DACLLI[1].SrcAddr = (uint32_t)LOOPBACK_DACBuffer[0];
+	LOOPBACK_DACLLI[1].DstAddr = (uint32_t)&(LPC_DAC->DACR);
+	LOOPBACK_DACLLI[1].NextLLI = (uint32_t)&LOOPBACK_DACLLI[0];
+	LOOPBACK_DACLLI[1].Control = control;
+
+	GPDMACfg.ChannelNum = LoopbackCfg->DACDMAChannel;
+	GPDMACfg.SrcMemAddr = (uint32_t)LOOPBACK_DACBuffer[0];
+	GPDMACfg.DstMemAddr = 0;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	GPDMACfg.SrcConn = 0;
+	GPDMACfg.DstConn = GPDMA_CONN_DAC;
+	GPDMACfg.DMALLI = (uint32_t)&LOOPBACK_DACLLI[0];
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+	GPDMA_Channel[LoopbackCfg->DACDMAChannel]->DMACCControl = LOOPBACK_DACLLI[1].Control;
+
+	/* Two blocks, one sample until the double buffered DACR reaches AOUT,
+	 * plus (NumTaps - 1) / 2 samples of group delay, in half samples */
+	LOOPBACK.LatencyNs = (uint32_t)(((uint64_t)(4 * LOOPBACK_BLOCK_SIZE + 2
+			+ LOOPBACK.NumTaps - 1) * 500000000UL) / LOOPBACK.SampleRate);
+
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Start/Stop loopback
+ * @param[in]	NewState	New State of loopback, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void LOOPBACK_Cmd(FunctionalState NewState)
+{
+	if (NewState == ENABLE) {
+		if (LOOPBACK.FIRMode) {
+			TRACE_DMA_START(LOOPBACK.DACDMAChannel, LOOPBACK_BLOCK_SIZE);
+			GPDMA_STATS_Start(LOOPBACK.DACDMAChannel);
+			GPDMA_ChannelCmd(LOOPBACK.DACDMAChannel, ENABLE);
+		}
+		TRACE_DMA_START(LOOPBACK.ADCDMAChannel, LOOPBACK.FIRMode ? LOOPBACK_BLOCK_SIZE : 0xFFF);
+		GPDMA_STATS_Start(LOOPBACK.ADCDMAChannel);
+		GPDMA_ChannelCmd(LOOPBACK.ADCDMAChannel, ENABLE);
+		TRACE_ADC_BURST(ENABLE);
+		ADC_BurstCmd(LPC_ADC, ENABLE);
+	} else {
+		ADC_BurstCmd(LPC_ADC, DISABLE);
+		TRACE_ADC_BURST(DISABLE);
+		GPDMA_ChannelCmd(LOOPBACK.ADCDMAChannel, DISABLE);
+		GPDMA_STATS_Stop(LOOPBACK.ADCDMAChannel);
+		if (LOOPBACK.FIRMode) {
+			GPDMA_ChannelCmd(LOOPBACK.DACDMAChannel, DISABLE);
+			GPDMA_STATS_Stop(LOOPBACK.DACDMAChannel);
+		}
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Get end-to-end latency from ADC input to DAC output
+ * @param		None
+ * @return 		Latency (ns)
+ **********************************************************************/
+uint32_t LOOPBACK_GetLatency(void)
+{
+	return LOOPBACK.LatencyNs;
+}
+
+/*********************************************************************//**
+ * @brief 		Get number of ADC blocks that completed while the previous
+ * 				block was still being filtered
+ * @param		None
+ * @return 		Overrun count
+ **********************************************************************/
+uint32_t LOOPBACK_GetOverruns(void)
+{
+	return LOOPBACK.Overruns;
+}
+
+/*********************************************************************//**
+ * @brief 		Loopback DMA handler, should be called from DMA_IRQHandler()
+ * 				when the ADC loopback channel has a terminal count interrupt.
+ * 				FIR mode only: in direct mode no transfer sets the I bit,
+ * 				so the channel never interrupts.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void LOOPBACK_DMAHandler(void)
+{
+	uint8_t done;
+
+	GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, LOOPBACK.ADCDMAChannel);
+	TRACE_DMA_TC(LOOPBACK.ADCDMAChannel);
+	GPDMA_STATS_TC(LOOPBACK.ADCDMAChannel, LOOPBACK_BLOCK_SIZE * 4);
+	done = LOOPBACK.Active;
+	LOOPBACK.Active ^= 1;
+	/* DAC is now playing block done ^ 1, refill block done */
+	LOOPBACK_FIRBlock(LOOPBACK_ADCBuffer[done], LOOPBACK_DACBuffer[done]);
+	/* Next block already finished: filtering is slower than real time */
+	if (GPDMA_IntGetStatus(GPDMA_STAT_RAWINTTC, LOOPBACK.ADCDMAChannel) == SET) {
+		LOOPBACK.Overruns++;
+	}
+}
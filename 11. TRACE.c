@@ -0,0 +1,133 @@
+/* ########################## TRACE — lpc17xx_trace.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Number of events kept in the ring, must be a power of 2 */
+#define TRACE_BUFFER_SIZE		512
+/** Dump header magic, "TRC1" */
+#define TRACE_MAGIC				0x31435254
+
+/** Event types */
+#define TRACE_EV_ISR_ENTER		1	/**< id: IRQn */
+#define TRACE_EV_ISR_EXIT		2	/**< id: IRQn */
+#define TRACE_EV_DMA_START		3	/**< id: DMA channel */
+#define TRACE_EV_DMA_TC			4	/**< id: DMA channel */
+#define TRACE_EV_DMA_ERR		5	/**< id: DMA channel */
+#define TRACE_EV_ADC_BURST		6	/**< arg: 1 start, 0 stop */
+#define TRACE_EV_TIM_MATCH		7	/**< id: timer address bits 19:12, arg: TIM_MRx_INT */
+#define TRACE_EV_USER			8	/**< id, arg: application defined */
+
+/*
+ * Driver hooks. With _TRACE undefined (see lpc17xx_libcfg.h) every hook
+ * expands to nothing and neither the ring nor TRACE_Record() is built.
+ */
+#ifdef _TRACE
+/** Place first/last in an IRQ handler, IRQn is taken from IPSR */
+#define TRACE_ISR_ENTER()			TRACE_Record(TRACE_EV_ISR_ENTER, (uint8_t)(__get_IPSR() - 16), 0)
+#define TRACE_ISR_EXIT()			TRACE_Record(TRACE_EV_ISR_EXIT, (uint8_t)(__get_IPSR() - 16), 0)
+#define TRACE_DMA_START(ch, size)	TRACE_Record(TRACE_EV_DMA_START, (ch), (size))
+#define TRACE_DMA_TC(ch)			TRACE_Record(TRACE_EV_DMA_TC, (ch), 0)
+#define TRACE_DMA_ERR(ch)			TRACE_Record(TRACE_EV_DMA_ERR, (ch), 0)
+#define TRACE_ADC_BURST(NewState)	TRACE_Record(TRACE_EV_ADC_BURST, 0, (NewState))
+/** Match interrupt acknowledged by TIM_ClearIntPending(), capture flags are
+ *  not recorded. LPC_TIM0..3 are recorded as 0x04, 0x08, 0x90, 0x94 */
+#define TRACE_TIM_MATCH(TIMx, flag)	TRACE_Record(TRACE_EV_TIM_MATCH, (uint8_t)((uint32_t)(TIMx) >> 12), (flag))
+#define TRACE_USER(id, arg)			TRACE_Record(TRACE_EV_USER, (id), (arg))
+#else
+#define TRACE_ISR_ENTER()
+#define TRACE_ISR_EXIT()
+#define TRACE_DMA_START(ch, size)
+#define TRACE_DMA_TC(ch)
+#define TRACE_DMA_ERR(ch)
+#define TRACE_ADC_BURST(NewState)
+#define TRACE_TIM_MATCH(TIMx, flag)
+#define TRACE_USER(id, arg)
+#define TRACE_Init()
+#endif /* _TRACE */
+
+/*********************************************************************//**
+ * @brief 		Enable the DWT cycle counter, the timestamp clock shared by
+ * 				trace, GPDMA statistics, COUNTER and ADC_WINDOW. The
+ * 				counter is never reset: it runs free and users subtract.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static __INLINE void TRACE_CycleCounterInit(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#ifdef _TRACE
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief Trace event, 8 bytes */
+typedef struct {
+	uint32_t Timestamp;		/**< DWT cycle counter */
+	uint8_t Type;			/**< TRACE_EV_x */
+	uint8_t Id;				/**< IRQn, DMA channel or timer address bits 19:12 */
+	uint16_t Arg;			/**< Event argument */
+} TRACE_Event_Type;
+
+/** @brief Trace ring. Dumping this whole structure from a debugger gives
+ *  the file read by tools/trace2json */
+typedef struct {
+	uint32_t Magic;			/**< TRACE_MAGIC */
+	uint32_t Size;			/**< TRACE_BUFFER_SIZE */
+	__IO uint32_t Head;		/**< Total number of events recorded */
+	uint32_t CoreClock;		/**< Timestamp frequency (Hz) */
+	TRACE_Event_Type Events[TRACE_BUFFER_SIZE];
+} TRACE_Buffer_Type;
+
+/* Public Variables ----------------------------------------------------------- */
+
+extern TRACE_Buffer_Type TRACE_Buffer;
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Record one event. Safe from thread and any interrupt
+ * 				priority: the slot is claimed with LDREX/STREX, then
+ * 				filled. The oldest event is overwritten when full.
+ * @param[in]	type	Event type, should be TRACE_EV_x
+ * @param[in]	id		IRQn, DMA channel or timer address bits 19:12
+ * @param[in]	arg		Event argument
+ * @return 		None
+ **********************************************************************/
+static __INLINE void TRACE_Record(uint8_t type, uint8_t id, uint16_t arg)
+{
+	TRACE_Event_Type *ev;
+	uint32_t idx;
+
+	do {
+		idx = __LDREXW(&TRACE_Buffer.Head);
+	} while (__STREXW(idx + 1, &TRACE_Buffer.Head));
+
+	ev = &TRACE_Buffer.Events[idx & (TRACE_BUFFER_SIZE - 1)];
+	ev->Timestamp = DWT->CYCCNT;
+	ev->Type = type;
+	ev->Id = id;
+	ev->Arg = arg;
+}
+
+/*********************************************************************//**
+ * @brief 		Initial trace
+ * 					- Enable the DWT cycle counter used for timestamps
+ * 					- Clear the ring
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void TRACE_Init(void)
+{
+	TRACE_CycleCounterInit();
+
+	TRACE_Buffer.Magic = TRACE_MAGIC;
+	TRACE_Buffer.Size = TRACE_BUFFER_SIZE;
+	TRACE_Buffer.CoreClock = SystemCoreClock;
+	TRACE_Buffer.Head = 0;
+}
+
+TRACE_Buffer_Type TRACE_Buffer;
+
+#endif /* _TRACE */
@@ -0,0 +1,230 @@
+/* ########################## DMA STATS — lpc17xx_gpdma_stats.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Number of GPDMA channels */
+#define GPDMA_STATS_NUM_CH		8
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief GPDMA channel statistics snapshot. Times are in DWT cycles */
+typedef struct {
+	uint32_t Transfers;		/**< Number of GPDMA_STATS_Start() calls */
+	uint32_t TCCount;		/**< Number of terminal count interrupts */
+	uint32_t ErrCount;		/**< Number of error interrupts */
+	uint32_t QueueCount;	/**< Number of GPDMA_STATS_Queue() calls */
+	uint32_t Bytes;			/**< Bytes moved, counted at terminal count */
+	uint32_t Reserved;
+	uint64_t BusyCycles;	/**< Time from start or previous terminal count to
+							terminal count or error */
+	uint64_t WaitCycles;	/**< Sum over all queued requests of the time from
+							GPDMA_STATS_Queue() to their start. Divide by
+							QueueCount for the mean wait */
+	uint64_t WindowCycles;	/**< Time since GPDMA_STATS_Reset(). Take a snapshot
+							at least every 2^32 cycles to keep it exact */
+} GPDMA_STATS_Type;
+
+/** @brief Per channel accumulator, updated from thread and DMA interrupt */
+typedef struct {
+	GPDMA_STATS_Type Stats;
+	uint32_t StartStamp;	/**< Start of the block in progress */
+	uint32_t QueueStamp;	/**< Time WaitCycles was last brought up to date */
+	uint8_t Running;		/**< Block in progress, StartStamp valid */
+	uint8_t Queued;			/**< Number of requests waiting, oldest first */
+	uint8_t Reserved[2];
+} GPDMA_STATS_CH_Type;
+
+/* Public Variables ----------------------------------------------------------- */
+
+extern GPDMA_STATS_CH_Type GPDMA_STATS_Channel[GPDMA_STATS_NUM_CH];
+
+GPDMA_STATS_CH_Type GPDMA_STATS_Channel[GPDMA_STATS_NUM_CH];
+
+/* Private Variables ---------------------------------------------------------- */
+
+/** Cycles since reset up to WindowStamp */
+static uint64_t GPDMA_STATS_Window;
+static uint32_t GPDMA_STATS_WindowStamp;
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Charge the time since the last update to every request
+ * 				still waiting, so WaitCycles holds the exact sum of waits
+ * 				without a stamp per request
+ * @param[in]	ch		Pointer to a GPDMA_STATS_CH_Type channel
+ * @param[in]	now		DWT cycle counter
+ * @return 		None
+ **********************************************************************/
+static __INLINE void GPDMA_STATS_Accrue(GPDMA_STATS_CH_Type *ch, uint32_t now)
+{
+	ch->Stats.WaitCycles += (uint64_t)ch->Queued * (now - ch->QueueStamp);
+	ch->QueueStamp = now;
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Record that a transfer was requested on a channel that
+ * 				is still busy. Optional, used for queue wait time. Each
+ * 				call is one request, started by one GPDMA_STATS_Start().
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @return 		None
+ **********************************************************************/
+static __INLINE void GPDMA_STATS_Queue(uint8_t channel)
+{
+	GPDMA_STATS_CH_Type *ch = &GPDMA_STATS_Channel[channel];
+
+	GPDMA_STATS_Accrue(ch, DWT->CYCCNT);
+	ch->Stats.QueueCount++;
+	if (ch->Queued < 0xFF) {
+		ch->Queued++;
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Record a transfer start, call right before
+ * 				GPDMA_ChannelCmd(channel, ENABLE)
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @return 		None
+ **********************************************************************/
+static __INLINE void GPDMA_STATS_Start(uint8_t channel)
+{
+	GPDMA_STATS_CH_Type *ch = &GPDMA_STATS_Channel[channel];
+	uint32_t now = DWT->CYCCNT;
+
+	GPDMA_STATS_Accrue(ch, now);
+	if (ch->Queued) {
+		ch->Queued--;
+	}
+	ch->Stats.Transfers++;
+	ch->StartStamp = now;
+	ch->Running = 1;
+}
+
+/*********************************************************************//**
+ * @brief 		Record a terminal count, call from DMA_IRQHandler() next
+ * 				to GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, channel).
+ * 				For linker lists each item counts as one block and the
+ * 				next one is assumed to start immediately.
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @param[in]	bytes		Bytes moved by the finished block
+ * @return 		None
+ **********************************************************************/
+static __INLINE void GPDMA_STATS_TC(uint8_t channel, uint32_t bytes)
+{
+	GPDMA_STATS_CH_Type *ch = &GPDMA_STATS_Channel[channel];
+	uint32_t now = DWT->CYCCNT;
+
+	ch->Stats.TCCount++;
+	ch->Stats.Bytes += bytes;
+	if (ch->Running) {
+		ch->Stats.BusyCycles += now - ch->StartStamp;
+	}
+	ch->StartStamp = now;
+}
+
+/*********************************************************************//**
+ * @brief 		Record an error, call from DMA_IRQHandler() next to
+ * 				GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, channel)
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @return 		None
+ **********************************************************************/
+static __INLINE void GPDMA_STATS_Err(uint8_t channel)
+{
+	GPDMA_STATS_CH_Type *ch = &GPDMA_STATS_Channel[channel];
+
+	ch->Stats.ErrCount++;
+	if (ch->Running) {
+		ch->Stats.BusyCycles += DWT->CYCCNT - ch->StartStamp;
+		ch->Running = 0;
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Record a transfer stop, call right after
+ * 				GPDMA_ChannelCmd(channel, DISABLE)
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @return 		None
+ **********************************************************************/
+static __INLINE void GPDMA_STATS_Stop(uint8_t channel)
+{
+	GPDMA_STATS_CH_Type *ch = &GPDMA_STATS_Channel[channel];
+
+	if (ch->Running) {
+		ch->Stats.BusyCycles += DWT->CYCCNT - ch->StartStamp;
+		ch->Running = 0;
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Clear the counters of all channels. Transfers in progress
+ * 				keep running and are timed from now on.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void GPDMA_STATS_Reset(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t now;
+	uint8_t i;
+
+	__disable_irq();
+	now = DWT->CYCCNT;
+	for (i = 0; i < GPDMA_STATS_NUM_CH; i++) {
+		GPDMA_STATS_Channel[i].Stats.Transfers = 0;
+		GPDMA_STATS_Channel[i].Stats.TCCount = 0;
+		GPDMA_STATS_Channel[i].Stats.ErrCount = 0;
+		GPDMA_STATS_Channel[i].Stats.QueueCount = 0;
+		GPDMA_STATS_Channel[i].Stats.Bytes = 0;
+		GPDMA_STATS_Channel[i].Stats.BusyCycles = 0;
+		GPDMA_STATS_Channel[i].Stats.WaitCycles = 0;
+		GPDMA_STATS_Channel[i].StartStamp = now;
+		GPDMA_STATS_Channel[i].QueueStamp = now;
+	}
+	GPDMA_STATS_Window = 0;
+	GPDMA_STATS_WindowStamp = now;
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief 		Initial GPDMA statistics
+ * 					- Enable the DWT cycle counter used for timestamps
+ * 					- Clear all channels
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void GPDMA_STATS_Init(void)
+{
+	uint8_t i;
+
+	TRACE_CycleCounterInit();
+
+	for (i = 0; i < GPDMA_STATS_NUM_CH; i++) {
+		GPDMA_STATS_Channel[i].Running = 0;
+		GPDMA_STATS_Channel[i].Queued = 0;
+	}
+	GPDMA_STATS_Reset();
+}
+
+/*********************************************************************//**
+ * @brief 		Get a consistent snapshot of one channel's statistics.
+ * 				Interrupts are masked only for the copy.
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @param[out]	StatsStruct	Pointer to a GPDMA_STATS_Type structure
+ * @return 		None
+ **********************************************************************/
+void GPDMA_STATS_GetSnapshot(uint8_t channel, GPDMA_STATS_Type *StatsStruct)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t now;
+
+	__disable_irq();
+	now = DWT->CYCCNT;
+	GPDMA_STATS_Window += now - GPDMA_STATS_WindowStamp;
+	GPDMA_STATS_WindowStamp = now;
+	GPDMA_STATS_Accrue(&GPDMA_STATS_Channel[channel], now);
+	*StatsStruct = GPDMA_STATS_Channel[channel].Stats;
+	StatsStruct->WindowCycles = GPDMA_STATS_Window;
+	__set_PRIMASK(primask);
+}
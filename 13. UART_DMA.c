@@ -0,0 +1,492 @@
+/* ########################## UART DMA — lpc17xx_uart_dma.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** TX ring size in bytes, must be a power of 2 */
+#define UART_DMA_TX_SIZE		1024
+/** RX ring block size in bytes, one terminal count per block */
+#define UART_DMA_RX_BLOCK		256
+/** Number of RX blocks in the ring, RX ring size must be a power of 2 */
+#define UART_DMA_RX_BLOCKS		4
+#define UART_DMA_RX_SIZE		(UART_DMA_RX_BLOCK * UART_DMA_RX_BLOCKS)
+
+/* Structures ----------------------------------------------------------------- */
+
+struct UART_DMA_Struct;
+
+/** @brief RX callback, called from interrupt with the number of unread
+ *  bytes. They may wrap the ring, in which case UART_DMA_RxGetReadPtr()
+ *  returns them in two contiguous parts */
+typedef void (*UART_DMA_RxCallback_Type)(struct UART_DMA_Struct *UARTDMAx, uint32_t available);
+
+/** @brief UART DMA stream configuration structure */
+typedef struct {
+	LPC_UART_TypeDef *UARTx;	/**< UART peripheral, should be LPC_UART0,
+								(LPC_UART_TypeDef *)LPC_UART1, LPC_UART2 or LPC_UART3 */
+	uint8_t TxChannel;			/**< DMA channel for TX, should be in range from 0 to 7 */
+	uint8_t RxChannel;			/**< DMA channel for RX, should be in range from 0 to 7 */
+	uint8_t TxConn;				/**< GPDMA_CONN_UARTn_Tx_MATn_0 */
+	uint8_t RxConn;				/**< GPDMA_CONN_UARTn_Rx_MATn_1 */
+	LPC_TIM_TypeDef *TIMx;		/**< Timer used for RX idle detection, one timer
+								per stream, should be LPC_TIM0..3 */
+	uint32_t IdleTimeout;		/**< RX idle timeout (us). Data is delivered when
+								nothing arrived for one to two timeouts. The
+								timer only runs from the first byte of a
+								burst until the line is idle */
+	UART_DMA_RxCallback_Type RxCallback;	/**< RX callback, may be NULL */
+} UART_DMA_CFG_Type;
+
+/** @brief UART DMA stream. Allocate one per UART, statically */
+typedef struct UART_DMA_Struct {
+	LPC_UART_TypeDef *UARTx;
+	LPC_TIM_TypeDef *TIMx;
+	UART_DMA_RxCallback_Type RxCallback;
+	uint8_t TxChannel;
+	uint8_t RxChannel;
+	uint8_t TxConn;
+	__IO uint8_t TxBusy;			/**< A TX transfer is in progress */
+	__IO uint32_t TxHead;			/**< Free running, written by application */
+	__IO uint32_t TxTail;			/**< Free running, advanced at TX terminal count */
+	uint32_t TxLen;					/**< Length of the TX transfer in progress */
+	__IO uint32_t RxTail;			/**< Free running, advanced by UART_DMA_RxConsume(),
+									moved to the DMA position on overrun */
+	__IO uint32_t RxBlocks;			/**< Number of RX blocks completed */
+	__IO uint32_t RxOverruns;		/**< Number of times DMA lapped the reader */
+	uint32_t RxLastPos;				/**< DMA write offset seen at the last idle check */
+	uint8_t RxIdleSent;				/**< Idle callback already sent for RxLastPos.
+									The idle timer only runs while clear */
+	__IO uint8_t RxResync;			/**< RxTail moved on overrun since the last
+									UART_DMA_RxGetReadPtr() */
+	uint8_t Reserved[2];
+	uint8_t TxBuf[UART_DMA_TX_SIZE];
+	uint8_t RxBuf[UART_DMA_RX_SIZE];
+	GPDMA_LLI_Type RxLLI[UART_DMA_RX_BLOCKS];
+} UART_DMA_Type;
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Start a TX transfer over the longest contiguous region
+ * 				between tail and head, if idle. Must be called with DMA
+ * 				interrupt masked or from the DMA interrupt.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @return 		ERROR if the TX DMA channel could not be set up, the data
+ * 				stays queued; SUCCESS otherwise
+ **********************************************************************/
+static Status UART_DMA_TxKick(UART_DMA_Type *UARTDMAx)
+{
+	GPDMA_Channel_CFG_Type GPDMACfg;
+	uint32_t tail, len;
+
+	if (UARTDMAx->TxBusy || (UARTDMAx->TxHead == UARTDMAx->TxTail)) {
+		return SUCCESS;
+	}
+
+	tail = UARTDMAx->TxTail & (UART_DMA_TX_SIZE - 1);
+	len = UARTDMAx->TxHead - UARTDMAx->TxTail;
+	if (len > UART_DMA_TX_SIZE - tail) {
+		len = UART_DMA_TX_SIZE - tail;
+	}
+	if (len > 0xFFF) {
+		len = 0xFFF;
+	}
+
+	GPDMACfg.ChannelNum = UARTDMAx->TxChannel;
+	GPDMACfg.SrcMemAddr = (uint32_t)&UARTDMAx->TxBuf[tail];
+	GPDMACfg.DstMemAddr = 0;
+	GPDMACfg.TransferSize = len;
+	GPDMACfg.TransferWidth = 0;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	GPDMACfg.SrcConn = 0;
+	GPDMACfg.DstConn = UARTDMAx->TxConn;
+	GPDMACfg.DMALLI = 0;
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		/* Stay idle so the next commit retries */
+		TRACE_DMA_ERR(UARTDMAx->TxChannel);
+		GPDMA_STATS_Err(UARTDMAx->TxChannel);
+		return ERROR;
+	}
+
+	UARTDMAx->TxLen = len;
+	UARTDMAx->TxBusy = 1;
+	TRACE_DMA_START(UARTDMAx->TxChannel, len);
+	GPDMA_STATS_Start(UARTDMAx->TxChannel);
+	GPDMA_ChannelCmd(UARTDMAx->TxChannel, ENABLE);
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Get the RX write offset of DMA in the ring
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @return 		Offset of the next byte DMA will write, 0..UART_DMA_RX_SIZE-1
+ **********************************************************************/
+static __INLINE uint32_t UART_DMA_RxPos(UART_DMA_Type *UARTDMAx)
+{
+	return (GPDMA_Channel[UARTDMAx->RxChannel]->DMACCDestAddr
+			- (uint32_t)UARTDMAx->RxBuf) & (UART_DMA_RX_SIZE - 1);
+}
+
+/*********************************************************************//**
+ * @brief 		Start timing a burst: mask the UART receive data interrupt
+ * 				and run the idle timer from now
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @return 		None
+ **********************************************************************/
+static void UART_DMA_IdleStart(UART_DMA_Type *UARTDMAx)
+{
+	UART_IntConfig(UARTDMAx->UARTx, UART_INTCFG_RBR, DISABLE);
+	UARTDMAx->RxLastPos = UART_DMA_RxPos(UARTDMAx);
+	UARTDMAx->RxIdleSent = 0;
+	TIM_ResetCounter(UARTDMAx->TIMx);
+	TIM_Cmd(UARTDMAx->TIMx, ENABLE);
+}
+
+/*********************************************************************//**
+ * @brief 		Arm RX idle detection: stop the idle timer and wait for
+ * 				the next byte with the UART receive data interrupt. Bytes
+ * 				that arrived while disarming restart the timer at once.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[in]	pos			DMA write offset at the last idle check
+ * @return 		None
+ **********************************************************************/
+static void UART_DMA_IdleArm(UART_DMA_Type *UARTDMAx, uint32_t pos)
+{
+	TIM_Cmd(UARTDMAx->TIMx, DISABLE);
+	UART_IntConfig(UARTDMAx->UARTx, UART_INTCFG_RBR, ENABLE);
+	if (UART_DMA_RxPos(UARTDMAx) != pos) {
+		UART_DMA_IdleStart(UARTDMAx);
+	}
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Initial UART DMA stream
+ * 					- UART FIFO in DMA mode, RX trigger at 1 character
+ * 					- RX: circular linker list over the RX ring, one
+ * 					  terminal count interrupt per block
+ * 					- Timer for RX idle detection, started by the UART
+ * 					  receive data interrupt on the first byte of a burst
+ * 				UART_Init() and GPDMA_Init() must have been called before.
+ * 				The UART, timer and DMA interrupts should be enabled in
+ * 				the NVIC with the same priority.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[in]	UARTDMACfg	Pointer to a UART_DMA_CFG_Type structure
+ * @return 		ERROR if the RX DMA channel is enabled before
+ * 				or SUCCESS if the stream is configured successfully
+ **********************************************************************/
+Status UART_DMA_Init(UART_DMA_Type *UARTDMAx, UART_DMA_CFG_Type *UARTDMACfg)
+{
+	GPDMA_Channel_CFG_Type GPDMACfg;
+	UART_FIFO_CFG_Type FIFOCfg;
+	TIM_TIMERCFG_Type TIMCfg;
+	TIM_MATCHCFG_Type MatchCfg;
+	uint32_t i, next;
+
+	UARTDMAx->UARTx = UARTDMACfg->UARTx;
+	UARTDMAx->TIMx = UARTDMACfg->TIMx;
+	UARTDMAx->RxCallback = UARTDMACfg->RxCallback;
+	UARTDMAx->TxChannel = UARTDMACfg->TxChannel;
+	UARTDMAx->RxChannel = UARTDMACfg->RxChannel;
+	UARTDMAx->TxConn = UARTDMACfg->TxConn;
+	UARTDMAx->TxBusy = 0;
+	UARTDMAx->TxHead = 0;
+	UARTDMAx->TxTail = 0;
+	UARTDMAx->RxTail = 0;
+	UARTDMAx->RxBlocks = 0;
+	UARTDMAx->RxOverruns = 0;
+	UARTDMAx->RxLastPos = 0;
+	UARTDMAx->RxIdleSent = 1;
+	UARTDMAx->RxResync = 0;
+
+	UART_FIFOConfigStructInit(&FIFOCfg);
+	FIFOCfg.FIFO_DMAMode = ENABLE;
+	FIFOCfg.FIFO_Level = UART_FIFO_TRGLEV0;
+	UART_FIFOConfig(UARTDMACfg->UARTx, &FIFOCfg);
+	UART_TxCmd(UARTDMACfg->UARTx, ENABLE);
+
+	/* Block k is followed by block k + 1, last block by block 0 */
+	for (i = 0; i < UART_DMA_RX_BLOCKS; i++) {
+		next = (i + 1) % UART_DMA_RX_BLOCKS;
+		UARTDMAx->RxLLI[i].SrcAddr = (uint32_t)&(UARTDMACfg->UARTx->RBR);
+		UARTDMAx->RxLLI[i].DstAddr = (uint32_t)&UARTDMAx->RxBuf[next * UART_DMA_RX_BLOCK];
+		UARTDMAx->RxLLI[i].NextLLI = (uint32_t)&UARTDMAx->RxLLI[next];
+		UARTDMAx->RxLLI[i].Control = GPDMA_DMACCxControl_TransferSize(UART_DMA_RX_BLOCK)
+				| GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_BYTE)
+				| GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_BYTE)
+				| GPDMA_DMACCxControl_DI
+				| GPDMA_DMACCxControl_I;
+	}
+
+	GPDMACfg.ChannelNum = UARTDMACfg->RxChannel;
+	GPDMACfg.SrcMemAddr = 0;
+	GPDMACfg.DstMemAddr = (uint32_t)UARTDMAx->RxBuf;
+	GPDMACfg.TransferSize = UART_DMA_RX_BLOCK;
+	GPDMACfg.TransferWidth = 0;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+	GPDMACfg.SrcConn = UARTDMACfg->RxConn;
+	GPDMACfg.DstConn = 0;
+	GPDMACfg.DMALLI = (uint32_t)&UARTDMAx->RxLLI[0];
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+
+	TIMCfg.PrescaleOption = TIM_PRESCALE_USVAL;
+	TIMCfg.PrescaleValue = 1;
+	TIM_Init(UARTDMACfg->TIMx, TIM_TIMER_MODE, &TIMCfg);
+	MatchCfg.MatchChannel = 0;
+	MatchCfg.IntOnMatch = ENABLE;
+	MatchCfg.ResetOnMatch = ENABLE;
+	MatchCfg.StopOnMatch = DISABLE;
+	MatchCfg.ExtMatchOutputType = TIM_EXTMATCH_NOTHING;
+	MatchCfg.MatchValue = UARTDMACfg->IdleTimeout;
+	TIM_ConfigMatch(UARTDMACfg->TIMx, &MatchCfg);
+
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Start/Stop RX stream and its idle timer. TX runs whenever
+ * 				data is committed.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[in]	NewState	New State of RX stream, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void UART_DMA_RxCmd(UART_DMA_Type *UARTDMAx, FunctionalState NewState)
+{
+	if (NewState == ENABLE) {
+		TRACE_DMA_START(UARTDMAx->RxChannel, UART_DMA_RX_BLOCK);
+		GPDMA_STATS_Start(UARTDMAx->RxChannel);
+		GPDMA_ChannelCmd(UARTDMAx->RxChannel, ENABLE);
+		UARTDMAx->RxLastPos = UART_DMA_RxPos(UARTDMAx);
+		UARTDMAx->RxIdleSent = 1;
+		UART_DMA_IdleArm(UARTDMAx, UARTDMAx->RxLastPos);
+	} else {
+		UART_IntConfig(UARTDMAx->UARTx, UART_INTCFG_RBR, DISABLE);
+		TIM_Cmd(UARTDMAx->TIMx, DISABLE);
+		GPDMA_ChannelCmd(UARTDMAx->RxChannel, DISABLE);
+		GPDMA_STATS_Stop(UARTDMAx->RxChannel);
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Get the contiguous free region of the TX ring. Write the
+ * 				data in place, then call UART_DMA_TxCommit().
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[out]	len			Number of bytes that can be written at the
+ * 							returned pointer, 0 if the ring is full
+ * @return 		Pointer to the free region
+ **********************************************************************/
+uint8_t *UART_DMA_TxGetWritePtr(UART_DMA_Type *UARTDMAx, uint32_t *len)
+{
+	uint32_t head = UARTDMAx->TxHead & (UART_DMA_TX_SIZE - 1);
+	uint32_t room = UART_DMA_TX_SIZE - (UARTDMAx->TxHead - UARTDMAx->TxTail);
+
+	*len = (room < UART_DMA_TX_SIZE - head) ? room : (UART_DMA_TX_SIZE - head);
+	return &UARTDMAx->TxBuf[head];
+}
+
+/*********************************************************************//**
+ * @brief 		Hand written bytes to DMA and start sending if idle
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[in]	len			Number of bytes written, should not exceed
+ * 							the length from UART_DMA_TxGetWritePtr()
+ * @return 		ERROR if the TX DMA channel could not be set up, the bytes
+ * 				stay queued and the next commit retries; SUCCESS otherwise
+ **********************************************************************/
+Status UART_DMA_TxCommit(UART_DMA_Type *UARTDMAx, uint32_t len)
+{
+	uint32_t primask = __get_PRIMASK();
+	Status ret;
+
+	UARTDMAx->TxHead += len;
+	__disable_irq();
+	if (UARTDMAx->TxBusy && (UARTDMAx->TxHead - len == UARTDMAx->TxTail + UARTDMAx->TxLen)) {
+		/* First data behind the transfer in progress: one queued transfer,
+		 * later commits join it */
+		GPDMA_STATS_Queue(UARTDMAx->TxChannel);
+	}
+	ret = UART_DMA_TxKick(UARTDMAx);
+	__set_PRIMASK(primask);
+	return ret;
+}
+
+/*********************************************************************//**
+ * @brief 		Copy a buffer into the TX ring and send it
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[in]	txbuf		Pointer to data
+ * @param[in]	buflen		Length of data
+ * @return 		Number of bytes queued, less than buflen if the ring is full
+ **********************************************************************/
+uint32_t UART_DMA_Send(UART_DMA_Type *UARTDMAx, const uint8_t *txbuf, uint32_t buflen)
+{
+	uint8_t *dst;
+	uint32_t len, i, sent = 0;
+
+	while (sent < buflen) {
+		dst = UART_DMA_TxGetWritePtr(UARTDMAx, &len);
+		if (len == 0) {
+			break;
+		}
+		if (len > buflen - sent) {
+			len = buflen - sent;
+		}
+		for (i = 0; i < len; i++) {
+			dst[i] = txbuf[sent + i];
+		}
+		UART_DMA_TxCommit(UARTDMAx, len);
+		sent += len;
+	}
+	return sent;
+}
+
+/*********************************************************************//**
+ * @brief 		Get the contiguous region of received data. Process the
+ * 				data in place, then call UART_DMA_RxConsume().
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[out]	len			Number of bytes readable at the returned pointer
+ * @return 		Pointer to the received data
+ **********************************************************************/
+uint8_t *UART_DMA_RxGetReadPtr(UART_DMA_Type *UARTDMAx, uint32_t *len)
+{
+	uint32_t tail, pos;
+
+	/* Clear before reading the tail, a resync after this is seen by RxConsume */
+	UARTDMAx->RxResync = 0;
+	tail = UARTDMAx->RxTail & (UART_DMA_RX_SIZE - 1);
+	pos = UART_DMA_RxPos(UARTDMAx);
+
+	*len = (pos >= tail) ? (pos - tail) : (UART_DMA_RX_SIZE - tail);
+	return &UARTDMAx->RxBuf[tail];
+}
+
+/*********************************************************************//**
+ * @brief 		Release received bytes back to DMA. If an overrun moved the
+ * 				tail since UART_DMA_RxGetReadPtr(), the bytes were already
+ * 				dropped and the tail is left at the DMA position.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @param[in]	len			Number of bytes processed, should not exceed
+ * 							the length from UART_DMA_RxGetReadPtr()
+ * @return 		None
+ **********************************************************************/
+void UART_DMA_RxConsume(UART_DMA_Type *UARTDMAx, uint32_t len)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	/* DMA handler may move RxTail on overrun, update it atomically */
+	__disable_irq();
+	if (!UARTDMAx->RxResync) {
+		UARTDMAx->RxTail += len;
+	}
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief 		Get number of times DMA overwrote unread RX data
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @return 		Overrun count
+ **********************************************************************/
+uint32_t UART_DMA_GetRxOverruns(UART_DMA_Type *UARTDMAx)
+{
+	return UARTDMAx->RxOverruns;
+}
+
+/*********************************************************************//**
+ * @brief 		UART DMA handler, should be called from DMA_IRQHandler()
+ * 				for each stream. Handles TX and RX terminal count and error.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @return 		None
+ **********************************************************************/
+void UART_DMA_DMAHandler(UART_DMA_Type *UARTDMAx)
+{
+	uint32_t unread;
+
+	if (GPDMA_IntGetStatus(GPDMA_STAT_INTTC, UARTDMAx->TxChannel)) {
+		GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, UARTDMAx->TxChannel);
+		TRACE_DMA_TC(UARTDMAx->TxChannel);
+		GPDMA_STATS_TC(UARTDMAx->TxChannel, UARTDMAx->TxLen);
+		UARTDMAx->TxTail += UARTDMAx->TxLen;
+		UARTDMAx->TxBusy = 0;
+		UART_DMA_TxKick(UARTDMAx);
+	}
+	if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, UARTDMAx->TxChannel)) {
+		GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, UARTDMAx->TxChannel);
+		TRACE_DMA_ERR(UARTDMAx->TxChannel);
+		GPDMA_STATS_Err(UARTDMAx->TxChannel);
+		/* Drop the failed region and go on with the rest */
+		UARTDMAx->TxTail += UARTDMAx->TxLen;
+		UARTDMAx->TxBusy = 0;
+		UART_DMA_TxKick(UARTDMAx);
+	}
+
+	if (GPDMA_IntGetStatus(GPDMA_STAT_INTTC, UARTDMAx->RxChannel)) {
+		GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, UARTDMAx->RxChannel);
+		TRACE_DMA_TC(UARTDMAx->RxChannel);
+		GPDMA_STATS_TC(UARTDMAx->RxChannel, UART_DMA_RX_BLOCK);
+		UARTDMAx->RxBlocks++;
+		/* Reader must stay at least one block ahead of DMA */
+		unread = UARTDMAx->RxBlocks * UART_DMA_RX_BLOCK - UARTDMAx->RxTail;
+		if (unread > UART_DMA_RX_SIZE - UART_DMA_RX_BLOCK) {
+			UARTDMAx->RxOverruns++;
+			UARTDMAx->RxTail = UARTDMAx->RxBlocks * UART_DMA_RX_BLOCK;
+			UARTDMAx->RxResync = 1;
+			unread = 0;
+		}
+		UARTDMAx->RxLastPos = UART_DMA_RxPos(UARTDMAx);
+		UARTDMAx->RxIdleSent = 1;
+		if (UARTDMAx->RxCallback && unread) {
+			UARTDMAx->RxCallback(UARTDMAx, unread);
+		}
+	}
+	if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, UARTDMAx->RxChannel)) {
+		GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, UARTDMAx->RxChannel);
+		TRACE_DMA_ERR(UARTDMAx->RxChannel);
+		GPDMA_STATS_Err(UARTDMAx->RxChannel);
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		RX idle handler, should be called from the stream timer
+ * 				TIMERn_IRQHandler(). Delivers a partial block when DMA
+ * 				has not moved for a whole timeout period, then stops the
+ * 				timer until the next burst. The timer, UART and DMA
+ * 				interrupts should have the same priority.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @return 		None
+ **********************************************************************/
+void UART_DMA_IdleHandler(UART_DMA_Type *UARTDMAx)
+{
+	uint32_t pos, unread;
+
+	TIM_ClearIntPending(UARTDMAx->TIMx, TIM_MR0_INT);
+	pos = UART_DMA_RxPos(UARTDMAx);
+	if (pos != UARTDMAx->RxLastPos) {
+		UARTDMAx->RxLastPos = pos;
+		UARTDMAx->RxIdleSent = 0;
+		return;
+	}
+	if (!UARTDMAx->RxIdleSent) {
+		UARTDMAx->RxIdleSent = 1;
+		unread = (pos - UARTDMAx->RxTail) & (UART_DMA_RX_SIZE - 1);
+		if (UARTDMAx->RxCallback && unread) {
+			UARTDMAx->RxCallback(UARTDMAx, unread);
+		}
+	}
+	/* Line idle and all data delivered, no timer interrupts until the next byte */
+	UART_DMA_IdleArm(UARTDMAx, pos);
+}
+
+/*********************************************************************//**
+ * @brief 		UART handler, should be called from UARTn_IRQHandler().
+ * 				The receive data interrupt is only enabled while the line
+ * 				is idle, so it fires once on the first byte of a burst;
+ * 				DMA has already taken the byte.
+ * @param[in]	UARTDMAx	Pointer to a UART_DMA_Type stream
+ * @return 		None
+ **********************************************************************/
+void UART_DMA_UARTHandler(UART_DMA_Type *UARTDMAx)
+{
+	UART_DMA_IdleStart(UARTDMAx);
+}
@@ -0,0 +1,341 @@
+/* ########################## SSP DMA — lpc17xx_ssp_dma.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Byte sent for segments with no TX data */
+#define SSP_DMA_DUMMY_BYTE		0xFF
+/** Maximum length of one DMA transfer, longer segments are split */
+#define SSP_DMA_MAX_CHUNK		0xFFF
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief One segment of a transaction */
+typedef struct {
+	const uint8_t *TxData;	/**< Data to send, NULL to send SSP_DMA_DUMMY_BYTE */
+	uint8_t *RxData;		/**< Buffer for received data, NULL to discard */
+	uint32_t Length;		/**< Length of segment in bytes */
+	uint8_t CSRelease;		/**< ENABLE: pulse chip select high after this
+							segment (ignored on the last segment). The high
+							time is a few core cycles plus the DMA setup of
+							the next segment */
+	uint8_t Reserved[3];
+} SSP_DMA_SEGMENT_Type;
+
+struct SSP_DMA_Transaction_Struct;
+
+/** @brief Completion callback, called from DMA interrupt */
+typedef void (*SSP_DMA_Callback_Type)(struct SSP_DMA_Transaction_Struct *Transaction, Status result);
+
+/** @brief Transaction: chip select, segments and callback. Must stay valid
+ *  until its callback is called */
+typedef struct SSP_DMA_Transaction_Struct {
+	SSP_DMA_SEGMENT_Type *Segments;	/**< Array of segments */
+	uint32_t NumSegments;			/**< Number of segments */
+	uint8_t CSPort;					/**< Chip select GPIO port, should be 0..4 */
+	uint8_t Reserved[3];
+	uint32_t CSPin;					/**< Chip select pin mask, active low */
+	SSP_DMA_Callback_Type Callback;	/**< Completion callback, may be NULL */
+	struct SSP_DMA_Transaction_Struct *Next;	/**< Queue link, used by driver */
+} SSP_DMA_Transaction_Type;
+
+/** @brief SSP DMA configuration structure */
+typedef struct {
+	LPC_SSP_TypeDef *SSPx;	/**< SSP peripheral, should be LPC_SSP0 or LPC_SSP1 */
+	uint8_t TxChannel;		/**< DMA channel for TX, should be in range from 0 to 7 */
+	uint8_t RxChannel;		/**< DMA channel for RX, should be in range from 0 to 7,
+							should have higher priority (lower number) than TxChannel */
+	uint8_t TxConn;			/**< GPDMA_CONN_SSP0_Tx or GPDMA_CONN_SSP1_Tx */
+	uint8_t RxConn;			/**< GPDMA_CONN_SSP0_Rx or GPDMA_CONN_SSP1_Rx */
+} SSP_DMA_CFG_Type;
+
+/** @brief SSP DMA bus. Allocate one per SSP, statically */
+typedef struct {
+	LPC_SSP_TypeDef *SSPx;
+	uint8_t TxChannel;
+	uint8_t RxChannel;
+	uint8_t TxConn;
+	uint8_t RxConn;
+	SSP_DMA_Transaction_Type *Head;	/**< Transaction in progress, NULL if idle */
+	SSP_DMA_Transaction_Type *Tail;	/**< Last queued transaction */
+	uint32_t Segment;				/**< Index of the segment in progress */
+	uint32_t Offset;				/**< Bytes of the segment already transferred */
+	uint32_t ChunkLen;				/**< Length of the DMA transfer in progress */
+	uint8_t DummyTx;				/**< Source for dummy TX bytes */
+	uint8_t DummyRx;				/**< Sink for discarded RX bytes */
+	uint8_t Reserved[2];
+} SSP_DMA_Type;
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Start the next chunk of the current segment on both
+ * 				channels, RX first so no received byte is missed
+ * @param[in]	SSPDMAx	Pointer to a SSP_DMA_Type bus
+ * @return 		ERROR if a channel could not be set up (both are left
+ * 				disabled), SUCCESS if the chunk is running
+ **********************************************************************/
+static Status SSP_DMA_StartChunk(SSP_DMA_Type *SSPDMAx)
+{
+	GPDMA_Channel_CFG_Type GPDMACfg;
+	SSP_DMA_SEGMENT_Type *seg = &SSPDMAx->Head->Segments[SSPDMAx->Segment];
+	uint32_t len = seg->Length - SSPDMAx->Offset;
+
+	if (len > SSP_DMA_MAX_CHUNK) {
+		len = SSP_DMA_MAX_CHUNK;
+	}
+	SSPDMAx->ChunkLen = len;
+
+	GPDMACfg.TransferSize = len;
+	GPDMACfg.TransferWidth = 0;
+	GPDMACfg.DMALLI = 0;
+
+	GPDMACfg.ChannelNum = SSPDMAx->RxChannel;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+	GPDMACfg.SrcMemAddr = 0;
+	GPDMACfg.SrcConn = SSPDMAx->RxConn;
+	GPDMACfg.DstConn = 0;
+	GPDMACfg.DstMemAddr = (seg->RxData != NULL) ? (uint32_t)&seg->RxData[SSPDMAx->Offset]
+			: (uint32_t)&SSPDMAx->DummyRx;
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+	if (seg->RxData == NULL) {
+		GPDMA_Channel[SSPDMAx->RxChannel]->DMACCControl &= ~GPDMA_DMACCxControl_DI;
+	}
+
+	GPDMACfg.ChannelNum = SSPDMAx->TxChannel;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	GPDMACfg.DstMemAddr = 0;
+	GPDMACfg.SrcConn = 0;
+	GPDMACfg.DstConn = SSPDMAx->TxConn;
+	GPDMACfg.SrcMemAddr = (seg->TxData != NULL) ? (uint32_t)&seg->TxData[SSPDMAx->Offset]
+			: (uint32_t)&SSPDMAx->DummyTx;
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+	if (seg->TxData == NULL) {
+		GPDMA_Channel[SSPDMAx->TxChannel]->DMACCControl &= ~GPDMA_DMACCxControl_SI;
+	}
+	/* Completion is taken from RX, TX terminal count is not needed */
+	GPDMA_Channel[SSPDMAx->TxChannel]->DMACCControl &= ~GPDMA_DMACCxControl_I;
+
+	TRACE_DMA_START(SSPDMAx->RxChannel, len);
+	GPDMA_ChannelCmd(SSPDMAx->RxChannel, ENABLE);
+	GPDMA_ChannelCmd(SSPDMAx->TxChannel, ENABLE);
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Start the transaction at the head of the queue, the bus
+ * 				must be idle (no channel enabled)
+ * @param[in]	SSPDMAx	Pointer to a SSP_DMA_Type bus
+ * @return 		ERROR if its first chunk could not be started (chip select
+ * 				released), SUCCESS if it is running
+ **********************************************************************/
+static Status SSP_DMA_StartTransaction(SSP_DMA_Type *SSPDMAx)
+{
+	SSP_DMA_Transaction_Type *t = SSPDMAx->Head;
+
+	SSPDMAx->Segment = 0;
+	SSPDMAx->Offset = 0;
+	/* Flush stale RX data */
+	while (SSPDMAx->SSPx->SR & SSP_SR_RNE) {
+		(void)SSPDMAx->SSPx->DR;
+	}
+	GPIO_ClearValue(t->CSPort, t->CSPin);
+	if (SSP_DMA_StartChunk(SSPDMAx) == ERROR) {
+		GPIO_SetValue(t->CSPort, t->CSPin);
+		return ERROR;
+	}
+	/* Timed per transaction, so a queued one's wait ends at its own start */
+	GPDMA_STATS_Start(SSPDMAx->RxChannel);
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Finish the transaction at the head of the queue, start the
+ * 				next one, then call the callbacks. The next transaction is
+ * 				running before any callback, so a callback submitting a
+ * 				transaction only queues it or, on an idle bus, starts it.
+ * @param[in]	SSPDMAx	Pointer to a SSP_DMA_Type bus
+ * @param[in]	result	SUCCESS or ERROR
+ * @return 		None
+ **********************************************************************/
+static void SSP_DMA_Complete(SSP_DMA_Type *SSPDMAx, Status result)
+{
+	SSP_DMA_Transaction_Type *t = SSPDMAx->Head;
+	SSP_DMA_Transaction_Type *failed = NULL, **link = &failed, *next;
+
+	GPDMA_ChannelCmd(SSPDMAx->TxChannel, DISABLE);
+	GPDMA_ChannelCmd(SSPDMAx->RxChannel, DISABLE);
+	GPIO_SetValue(t->CSPort, t->CSPin);
+	SSPDMAx->Head = t->Next;
+
+	/* Transactions that cannot start are completed with ERROR; their
+	 * Next field now links the list of failed transactions */
+	while ((SSPDMAx->Head != NULL) && (SSP_DMA_StartTransaction(SSPDMAx) == ERROR)) {
+		GPDMA_ChannelCmd(SSPDMAx->TxChannel, DISABLE);
+		GPDMA_ChannelCmd(SSPDMAx->RxChannel, DISABLE);
+		*link = SSPDMAx->Head;
+		link = &SSPDMAx->Head->Next;
+		SSPDMAx->Head = SSPDMAx->Head->Next;
+	}
+	*link = NULL;
+	if (SSPDMAx->Head == NULL) {
+		SSPDMAx->Tail = NULL;
+	}
+
+	if (t->Callback != NULL) {
+		t->Callback(t, result);
+	}
+	while (failed != NULL) {
+		next = failed->Next;
+		if (failed->Callback != NULL) {
+			failed->Callback(failed, ERROR);
+		}
+		failed = next;
+	}
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Initial SSP DMA bus
+ * 				SSP_Init() and GPDMA_Init() must have been called before,
+ * 				and chip select pins configured as GPIO outputs, high.
+ * @param[in]	SSPDMAx	Pointer to a SSP_DMA_Type bus
+ * @param[in]	SSPDMACfg	Pointer to a SSP_DMA_CFG_Type structure
+ * @return 		None
+ **********************************************************************/
+void SSP_DMA_Init(SSP_DMA_Type *SSPDMAx, SSP_DMA_CFG_Type *SSPDMACfg)
+{
+	SSPDMAx->SSPx = SSPDMACfg->SSPx;
+	SSPDMAx->TxChannel = SSPDMACfg->TxChannel;
+	SSPDMAx->RxChannel = SSPDMACfg->RxChannel;
+	SSPDMAx->TxConn = SSPDMACfg->TxConn;
+	SSPDMAx->RxConn = SSPDMACfg->RxConn;
+	SSPDMAx->Head = NULL;
+	SSPDMAx->Tail = NULL;
+	SSPDMAx->DummyTx = SSP_DMA_DUMMY_BYTE;
+
+	SSP_DMACmd(SSPDMACfg->SSPx, SSP_DMA_TX, ENABLE);
+	SSP_DMACmd(SSPDMACfg->SSPx, SSP_DMA_RX, ENABLE);
+	SSP_Cmd(SSPDMACfg->SSPx, ENABLE);
+}
+
+/*********************************************************************//**
+ * @brief 		Queue a transaction. It starts at once if the bus is idle.
+ * 				Chip select is asserted for the whole transaction except
+ * 				after segments with CSRelease set.
+ * @param[in]	SSPDMAx	Pointer to a SSP_DMA_Type bus
+ * @param[in]	Transaction	Pointer to a SSP_DMA_Transaction_Type
+ * @return 		ERROR if the transaction has no segment or an empty one,
+ * 				or could not be started on an idle bus, SUCCESS if it is
+ * 				queued
+ **********************************************************************/
+Status SSP_DMA_Submit(SSP_DMA_Type *SSPDMAx, SSP_DMA_Transaction_Type *Transaction)
+{
+	uint32_t primask, i;
+
+	if ((Transaction->NumSegments == 0) || (Transaction->Segments == NULL)) {
+		return ERROR;
+	}
+	for (i = 0; i < Transaction->NumSegments; i++) {
+		if (Transaction->Segments[i].Length == 0) {
+			return ERROR;
+		}
+	}
+	Transaction->Next = NULL;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (SSPDMAx->Head == NULL) {
+		SSPDMAx->Head = Transaction;
+		SSPDMAx->Tail = Transaction;
+		if (SSP_DMA_StartTransaction(SSPDMAx) == ERROR) {
+			GPDMA_ChannelCmd(SSPDMAx->TxChannel, DISABLE);
+			GPDMA_ChannelCmd(SSPDMAx->RxChannel, DISABLE);
+			SSPDMAx->Head = NULL;
+			SSPDMAx->Tail = NULL;
+			__set_PRIMASK(primask);
+			return ERROR;
+		}
+	} else {
+		SSPDMAx->Tail->Next = Transaction;
+		SSPDMAx->Tail = Transaction;
+		GPDMA_STATS_Queue(SSPDMAx->RxChannel);
+	}
+	__set_PRIMASK(primask);
+
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Check if the bus has no transaction queued or in progress
+ * @param[in]	SSPDMAx	Pointer to a SSP_DMA_Type bus
+ * @return 		SET if idle, RESET if busy
+ **********************************************************************/
+FlagStatus SSP_DMA_IsIdle(SSP_DMA_Type *SSPDMAx)
+{
+	return (SSPDMAx->Head == NULL) ? SET : RESET;
+}
+
+/*********************************************************************//**
+ * @brief 		SSP DMA handler, should be called from DMA_IRQHandler()
+ * 				for each bus. Moves to the next chunk, segment or
+ * 				transaction when RX has received the last byte.
+ * @param[in]	SSPDMAx	Pointer to a SSP_DMA_Type bus
+ * @return 		None
+ **********************************************************************/
+void SSP_DMA_DMAHandler(SSP_DMA_Type *SSPDMAx)
+{
+	SSP_DMA_Transaction_Type *t = SSPDMAx->Head;
+	SSP_DMA_SEGMENT_Type *seg;
+
+	if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, SSPDMAx->TxChannel)
+			|| GPDMA_IntGetStatus(GPDMA_STAT_INTERR, SSPDMAx->RxChannel)) {
+		GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, SSPDMAx->TxChannel);
+		GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, SSPDMAx->RxChannel);
+		GPDMA_ChannelCmd(SSPDMAx->TxChannel, DISABLE);
+		GPDMA_ChannelCmd(SSPDMAx->RxChannel, DISABLE);
+		TRACE_DMA_ERR(SSPDMAx->RxChannel);
+		GPDMA_STATS_Err(SSPDMAx->RxChannel);
+		if (t != NULL) {
+			SSP_DMA_Complete(SSPDMAx, ERROR);
+		}
+		return;
+	}
+
+	if (!GPDMA_IntGetStatus(GPDMA_STAT_INTTC, SSPDMAx->RxChannel)) {
+		return;
+	}
+	GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, SSPDMAx->RxChannel);
+	TRACE_DMA_TC(SSPDMAx->RxChannel);
+	GPDMA_STATS_TC(SSPDMAx->RxChannel, SSPDMAx->ChunkLen);
+	if (t == NULL) {
+		return;
+	}
+
+	seg = &t->Segments[SSPDMAx->Segment];
+	SSPDMAx->Offset += SSPDMAx->ChunkLen;
+	if (SSPDMAx->Offset < seg->Length) {
+		if (SSP_DMA_StartChunk(SSPDMAx) == ERROR) {
+			SSP_DMA_Complete(SSPDMAx, ERROR);
+		}
+		return;
+	}
+
+	SSPDMAx->Segment++;
+	SSPDMAx->Offset = 0;
+	if (SSPDMAx->Segment >= t->NumSegments) {
+		SSP_DMA_Complete(SSPDMAx, SUCCESS);
+		return;
+	}
+	if (seg->CSRelease) {
+		GPIO_SetValue(t->CSPort, t->CSPin);
+		GPIO_ClearValue(t->CSPort, t->CSPin);
+	}
+	if (SSP_DMA_StartChunk(SSPDMAx) == ERROR) {
+		SSP_DMA_Complete(SSPDMAx, ERROR);
+	}
+}
@@ -0,0 +1,237 @@
+/* ########################## I2S STREAM — lpc17xx_i2s_stream.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Maximum block size in words, limited by the DMA transfer size */
+#define I2S_STREAM_MAX_BLOCK	0xFFF
+/** I2S FIFO depth in words */
+#define I2S_STREAM_FIFO_SIZE	8
+
+/* Structures ----------------------------------------------------------------- */
+
+struct I2S_STREAM_Struct;
+
+/** @brief Block callback, called from DMA interrupt when a block is free
+ *  to be refilled (TX) or holds new samples (RX). The block must be handed
+ *  back with I2S_STREAM_Release() before DMA reaches it again */
+typedef void (*I2S_STREAM_Callback_Type)(struct I2S_STREAM_Struct *I2SStream, uint32_t *block);
+
+/** @brief I2S stream configuration structure */
+typedef struct {
+	uint8_t Mode;			/**< I2S_TX_MODE or I2S_RX_MODE */
+	uint8_t DMAChannel;		/**< DMA channel, should be in range from 0 to 7 */
+	uint8_t DMAConn;		/**< GPDMA_CONN_I2S_Channel_0: I2S DMA1
+							GPDMA_CONN_I2S_Channel_1: I2S DMA2 */
+	uint8_t FIFODepth;		/**< FIFO level raising the DMA request, 1..7.
+							The DMA burst is the largest of 1 or 4 words that
+							fits the free (TX) or filled (RX) FIFO space at
+							the request: TX bursts 4 up to depth 4, RX from 4 */
+	uint32_t *Buffer;		/**< Two blocks of BlockSize words, for TX filled
+							with the first samples before start */
+	uint32_t BlockSize;		/**< Words per block, should be in range from 1 to
+							I2S_STREAM_MAX_BLOCK. Latency is one to two blocks,
+							interrupt rate is sample rate / BlockSize */
+	I2S_STREAM_Callback_Type Callback;	/**< Block callback */
+} I2S_STREAM_CFG_Type;
+
+/** @brief I2S stream, one per direction. Allocate statically */
+typedef struct I2S_STREAM_Struct {
+	uint32_t *Buffer;
+	uint32_t BlockSize;
+	I2S_STREAM_Callback_Type Callback;
+	uint8_t Mode;
+	uint8_t DMAChannel;
+	uint8_t DMAIndex;				/**< I2S_DMA_1 or I2S_DMA_2 */
+	uint8_t Next;					/**< Index of the block DMA finishes next */
+	__IO uint8_t Owned[2];			/**< Block handed to application, not released */
+	uint8_t Reserved[2];
+	__IO uint32_t Blocks;			/**< Number of blocks transferred */
+	__IO uint32_t Underruns;		/**< TX: block replayed before it was refilled */
+	__IO uint32_t Overruns;			/**< RX: block overwritten before it was read */
+	GPDMA_LLI_Type LLI[2];
+} I2S_STREAM_Type;
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Initial I2S stream
+ * 					- I2S DMA request on the FIFO level
+ * 					- Circular linker list over the two blocks, one
+ * 					  terminal count interrupt per block
+ * 				I2S_Init(), I2S_Config(), I2S_FreqConfig() and GPDMA_Init()
+ * 				must have been called before.
+ * @param[in]	I2SStream	Pointer to a I2S_STREAM_Type stream
+ * @param[in]	I2SStreamCfg	Pointer to a I2S_STREAM_CFG_Type structure
+ * @return 		ERROR if the DMA channel is enabled before, BlockSize or
+ * 				FIFODepth is out of range, SUCCESS if configured successfully
+ **********************************************************************/
+Status I2S_STREAM_Init(I2S_STREAM_Type *I2SStream, I2S_STREAM_CFG_Type *I2SStreamCfg)
+{
+	GPDMA_Channel_CFG_Type GPDMACfg;
+	I2S_DMAConf_Type DMACfg;
+	uint32_t i, control, space, burst;
+
+	if ((I2SStreamCfg->BlockSize == 0) || (I2SStreamCfg->BlockSize > I2S_STREAM_MAX_BLOCK)
+			|| (I2SStreamCfg->FIFODepth == 0) || (I2SStreamCfg->FIFODepth >= I2S_STREAM_FIFO_SIZE)) {
+		return ERROR;
+	}
+
+	I2SStream->Buffer = I2SStreamCfg->Buffer;
+	I2SStream->BlockSize = I2SStreamCfg->BlockSize;
+	I2SStream->Callback = I2SStreamCfg->Callback;
+	I2SStream->Mode = I2SStreamCfg->Mode;
+	I2SStream->DMAChannel = I2SStreamCfg->DMAChannel;
+	I2SStream->DMAIndex = (I2SStreamCfg->DMAConn == GPDMA_CONN_I2S_Channel_0) ? I2S_DMA_1 : I2S_DMA_2;
+	I2SStream->Next = 0;
+	I2SStream->Owned[0] = 0;
+	I2SStream->Owned[1] = 0;
+	I2SStream->Blocks = 0;
+	I2SStream->Underruns = 0;
+	I2SStream->Overruns = 0;
+
+	DMACfg.DMAIndex = I2SStream->DMAIndex;
+	DMACfg.depth = I2SStreamCfg->FIFODepth;
+	I2S_DMAConfig(LPC_I2S, &DMACfg, I2SStreamCfg->Mode);
+
+	/* FIFO words free (TX) or filled (RX) when the request is raised */
+	space = (I2SStreamCfg->Mode == I2S_TX_MODE) ? (I2S_STREAM_FIFO_SIZE - I2SStreamCfg->FIFODepth)
+			: I2SStreamCfg->FIFODepth;
+	burst = (space >= 4) ? GPDMA_BSIZE_4 : GPDMA_BSIZE_1;
+
+	/* Block 0 -> block 1 -> block 0 ..., interrupt at the end of each block */
+	control = GPDMA_DMACCxControl_TransferSize(I2SStreamCfg->BlockSize)
+			| GPDMA_DMACCxControl_SBSize(burst)
+			| GPDMA_DMACCxControl_DBSize(burst)
+			| GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD)
+			| ((I2SStreamCfg->Mode == I2S_TX_MODE) ? GPDMA_DMACCxControl_SI : GPDMA_DMACCxControl_DI)
+			| GPDMA_DMACCxControl_I;
+	for (i = 0; i < 2; i++) {
+		uint32_t *block = &I2SStreamCfg->Buffer[(i ^ 1) * I2SStreamCfg->BlockSize];
+
+		if (I2SStreamCfg->Mode == I2S_TX_MODE) {
+			I2SStream->LLI[i].SrcAddr = (uint32_t)block;
+			I2SStream->LLI[i].DstAddr = (uint32_t)&(LPC_I2S->I2STXFIFO);
+		} else {
+			I2SStream->LLI[i].SrcAddr = (uint32_t)&(LPC_I2S->I2SRXFIFO);
+			I2SStream->LLI[i].DstAddr = (uint32_t)block;
+		}
+		I2SStream->LLI[i].NextLLI = (uint32_t)&I2SStream->LLI[i ^ 1];
+		I2SStream->LLI[i].Control = control;
+	}
+
+	GPDMACfg.ChannelNum = I2SStreamCfg->DMAChannel;
+	GPDMACfg.TransferSize = I2SStreamCfg->BlockSize;
+	GPDMACfg.TransferWidth = 0;
+	GPDMACfg.DMALLI = (uint32_t)&I2SStream->LLI[0];
+	if (I2SStreamCfg->Mode == I2S_TX_MODE) {
+		GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+		GPDMACfg.SrcMemAddr = (uint32_t)I2SStreamCfg->Buffer;
+		GPDMACfg.DstMemAddr = 0;
+		GPDMACfg.SrcConn = 0;
+		GPDMACfg.DstConn = I2SStreamCfg->DMAConn;
+	} else {
+		GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+		GPDMACfg.SrcMemAddr = 0;
+		GPDMACfg.DstMemAddr = (uint32_t)I2SStreamCfg->Buffer;
+		GPDMACfg.SrcConn = I2SStreamCfg->DMAConn;
+		GPDMACfg.DstConn = 0;
+	}
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+	/* First block runs from block 0 like LLI[1], with the same burst */
+	GPDMA_Channel[I2SStreamCfg->DMAChannel]->DMACCControl = I2SStream->LLI[1].Control;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Start/Stop I2S stream
+ * @param[in]	I2SStream	Pointer to a I2S_STREAM_Type stream
+ * @param[in]	NewState	New State of stream, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void I2S_STREAM_Cmd(I2S_STREAM_Type *I2SStream, FunctionalState NewState)
+{
+	if (NewState == ENABLE) {
+		TRACE_DMA_START(I2SStream->DMAChannel, I2SStream->BlockSize);
+		GPDMA_STATS_Start(I2SStream->DMAChannel);
+		GPDMA_ChannelCmd(I2SStream->DMAChannel, ENABLE);
+		I2S_DMACmd(LPC_I2S, I2SStream->DMAIndex, I2SStream->Mode, ENABLE);
+		I2S_Start(LPC_I2S);
+	} else {
+		I2S_DMACmd(LPC_I2S, I2SStream->DMAIndex, I2SStream->Mode, DISABLE);
+		GPDMA_ChannelCmd(I2SStream->DMAChannel, DISABLE);
+		GPDMA_STATS_Stop(I2SStream->DMAChannel);
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Hand a block back to DMA after refilling (TX) or reading
+ * 				(RX) it. May be called from the callback or later.
+ * @param[in]	I2SStream	Pointer to a I2S_STREAM_Type stream
+ * @param[in]	block		Block pointer passed to the callback
+ * @return 		None
+ **********************************************************************/
+void I2S_STREAM_Release(I2S_STREAM_Type *I2SStream, uint32_t *block)
+{
+	I2SStream->Owned[(block == I2SStream->Buffer) ? 0 : 1] = 0;
+}
+
+/*********************************************************************//**
+ * @brief 		Get number of TX underruns (block replayed before it was
+ * 				released) or RX overruns (block overwritten before it was
+ * 				released)
+ * @param[in]	I2SStream	Pointer to a I2S_STREAM_Type stream
+ * @return 		Underrun count for TX, overrun count for RX
+ **********************************************************************/
+uint32_t I2S_STREAM_GetErrors(I2S_STREAM_Type *I2SStream)
+{
+	return (I2SStream->Mode == I2S_TX_MODE) ? I2SStream->Underruns : I2SStream->Overruns;
+}
+
+/*********************************************************************//**
+ * @brief 		I2S stream DMA handler, should be called from
+ * 				DMA_IRQHandler() for each stream. Hands the block DMA has
+ * 				just finished to the callback.
+ * @param[in]	I2SStream	Pointer to a I2S_STREAM_Type stream
+ * @return 		None
+ **********************************************************************/
+void I2S_STREAM_DMAHandler(I2S_STREAM_Type *I2SStream)
+{
+	uint32_t done;
+
+	if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, I2SStream->DMAChannel)) {
+		GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, I2SStream->DMAChannel);
+		TRACE_DMA_ERR(I2SStream->DMAChannel);
+		GPDMA_STATS_Err(I2SStream->DMAChannel);
+	}
+	if (!GPDMA_IntGetStatus(GPDMA_STAT_INTTC, I2SStream->DMAChannel)) {
+		return;
+	}
+	GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, I2SStream->DMAChannel);
+	TRACE_DMA_TC(I2SStream->DMAChannel);
+	GPDMA_STATS_TC(I2SStream->DMAChannel, I2SStream->BlockSize * 4);
+
+	done = I2SStream->Next;
+	I2SStream->Next ^= 1;
+	I2SStream->Blocks++;
+
+	/* DMA is now on the other block. If that one is still owned by the
+	 * application, it is being replayed (TX) or overwritten (RX) */
+	if (I2SStream->Owned[done ^ 1]) {
+		if (I2SStream->Mode == I2S_TX_MODE) {
+			I2SStream->Underruns++;
+		} else {
+			I2SStream->Overruns++;
+		}
+		I2SStream->Owned[done ^ 1] = 0;
+	}
+
+	I2SStream->Owned[done] = 1;
+	if (I2SStream->Callback != NULL) {
+		I2SStream->Callback(I2SStream, &I2SStream->Buffer[done * I2SStream->BlockSize]);
+	}
+}
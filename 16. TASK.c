@@ -0,0 +1,439 @@
+/* ########################## TASK — lpc17xx_task.h ########################## */
+
+/*
+ * Cooperative task executor without heap or per-task stack. A task is a
+ * function resumed at its last await point (switch on __LINE__), so locals
+ * do not survive an await: keep them in Task->Frame or Task->Arg. At most
+ * one await per source line. TASK_AWAIT() and TASK_DELAY() cannot be used
+ * inside a switch statement of the task body: their case labels would
+ * belong to the inner switch. Use if/else chains there.
+ *
+ *	static uint8_t Sampler(TASK_Type *Task)
+ *	{
+ *		TASK_BEGIN(Task);
+ *		for (;;) {
+ *			TASK_DMAStart(0, 256);
+ *			TASK_AWAIT(Task, &TASK_DMAEvent[0]);
+ *			if (Task->Result == ERROR) break;
+ *			TASK_DELAY(Task, 10);
+ *		}
+ *		TASK_END(Task);
+ *	}
+ */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Number of tasks in the static pool */
+#define TASK_MAX				8
+/** Words of per-task storage kept across awaits */
+#define TASK_FRAME_WORDS		8
+
+/** Task function return values */
+#define TASK_DONE				0	/**< Task finished, slot is freed */
+#define TASK_WAITING			1	/**< Task parked on an event, a delay or a yield */
+
+/** Task states */
+#define TASK_STATE_FREE			0
+#define TASK_STATE_READY		1
+#define TASK_STATE_WAITING		2
+#define TASK_STATE_SLEEPING		3
+#define TASK_STATE_RUNNING		4
+
+/** Open the task body, must be the first statement of the task function */
+#define TASK_BEGIN(Task)		switch ((Task)->Line) { case 0:
+/** Close the task body, must be the last statement of the task function */
+#define TASK_END(Task)			} (Task)->Line = 0; return TASK_DONE
+
+/** Wait for an event. Task->Result holds the value passed to TASK_Signal() */
+#define TASK_AWAIT(Task, Event)	do { (Task)->Line = __LINE__; \
+									if (TASK_Wait((Task), (Event)) == RESET) { return TASK_WAITING; } \
+									case __LINE__:; } while (0)
+/** Wait for a number of TASK_Tick() calls, 0 yields to the other ready tasks */
+#define TASK_DELAY(Task, ticks)	do { (Task)->Line = __LINE__; TASK_Sleep((Task), (ticks)); \
+									return TASK_WAITING; case __LINE__:; } while (0)
+#define TASK_YIELD(Task)		TASK_DELAY((Task), 0)
+
+/* Structures ----------------------------------------------------------------- */
+
+struct TASK_Struct;
+
+/** @brief Task function, returns TASK_DONE or TASK_WAITING */
+typedef uint8_t (*TASK_Func_Type)(struct TASK_Struct *Task);
+
+/** @brief Task control block, allocated from the static pool */
+typedef struct TASK_Struct {
+	TASK_Func_Type Func;
+	struct TASK_Struct *Next;		/**< Ready queue link */
+	void *Arg;						/**< Argument given to TASK_Create() */
+	uint32_t Result;				/**< Value of the last awaited event */
+	uint32_t Wake;					/**< Tick to wake at, valid when sleeping */
+	uint16_t Line;					/**< Resume point, 0 at start */
+	__IO uint8_t State;				/**< TASK_STATE_x */
+	uint8_t Reserved;
+	uint32_t Frame[TASK_FRAME_WORDS];	/**< Task locals kept across awaits */
+} TASK_Type;
+
+/** @brief Event a single task can wait on. Signalled from interrupt or
+ *  thread; a signal with no waiter is kept until the next await */
+typedef struct {
+	TASK_Type *volatile Waiter;		/**< Parked task, NULL if none */
+	__IO uint32_t Result;			/**< Value of the pending signal */
+	__IO uint8_t Pending;			/**< Signalled, not yet awaited */
+	uint8_t Reserved[3];
+} TASK_EVENT_Type;
+
+/* Public Variables ----------------------------------------------------------- */
+
+/** Signalled by TASK_DMAHandler(), Result is SUCCESS or ERROR. Also the
+ *  event to await for an ADC block moved by DMA */
+extern TASK_EVENT_Type TASK_DMAEvent[8];
+/** Signalled by TASK_ADCHandler(), Result is the 12-bit conversion result */
+extern TASK_EVENT_Type TASK_ADCEvent;
+/** Signalled by TASK_EINTHandler(), index is EXTI_LINE_ENUM */
+extern TASK_EVENT_Type TASK_EINTEvent[4];
+/** Signalled by TASK_GPIOHandler(), index 0: port 0, 1: port 2.
+ *  Result is the mask of pins with an edge since the last await */
+extern TASK_EVENT_Type TASK_GPIOEvent[2];
+
+/* Private Variables ---------------------------------------------------------- */
+
+TASK_EVENT_Type TASK_DMAEvent[8];
+TASK_EVENT_Type TASK_ADCEvent;
+TASK_EVENT_Type TASK_EINTEvent[4];
+TASK_EVENT_Type TASK_GPIOEvent[2];
+
+static TASK_Type TASK_Pool[TASK_MAX];
+static TASK_Type *TASK_ReadyHead;
+static TASK_Type *TASK_ReadyTail;
+static __IO uint32_t TASK_Ticks;
+/** DMA channels whose interrupts are handled by TASK_DMAHandler() */
+static uint8_t TASK_DMAMask;
+/** Bytes of the transfer started by TASK_DMAStart(), for GPDMA_STATS_TC() */
+static uint32_t TASK_DMABytes[8];
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Append a task to the ready queue, interrupts must be masked
+ * @param[in]	Task	Pointer to a TASK_Type task
+ * @return 		None
+ **********************************************************************/
+static void TASK_Push(TASK_Type *Task)
+{
+	Task->State = TASK_STATE_READY;
+	Task->Next = NULL;
+	if (TASK_ReadyTail == NULL) {
+		TASK_ReadyHead = Task;
+	} else {
+		TASK_ReadyTail->Next = Task;
+	}
+	TASK_ReadyTail = Task;
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Create a task and queue it to run
+ * @param[in]	func	Task function
+ * @param[in]	arg		Argument, available as Task->Arg
+ * @return 		Pointer to the task, NULL if the pool is full
+ **********************************************************************/
+TASK_Type *TASK_Create(TASK_Func_Type func, void *arg)
+{
+	uint32_t primask = __get_PRIMASK();
+	TASK_Type *Task = NULL;
+	uint32_t i;
+
+	__disable_irq();
+	for (i = 0; i < TASK_MAX; i++) {
+		if (TASK_Pool[i].State == TASK_STATE_FREE) {
+			Task = &TASK_Pool[i];
+			Task->Func = func;
+			Task->Arg = arg;
+			Task->Result = 0;
+			Task->Line = 0;
+			TASK_Push(Task);
+			break;
+		}
+	}
+	__set_PRIMASK(primask);
+	return Task;
+}
+
+/*********************************************************************//**
+ * @brief 		Park a task on an event, use TASK_AWAIT() instead
+ * @param[in]	Task	Pointer to a TASK_Type task
+ * @param[in]	Event	Pointer to a TASK_EVENT_Type event
+ * @return 		SET if the event was already signalled (Task->Result is
+ * 				valid and the task continues), RESET if the task is parked
+ **********************************************************************/
+FlagStatus TASK_Wait(TASK_Type *Task, TASK_EVENT_Type *Event)
+{
+	uint32_t primask = __get_PRIMASK();
+	FlagStatus ret;
+
+	__disable_irq();
+	if (Event->Pending) {
+		Event->Pending = 0;
+		Task->Result = Event->Result;
+		ret = SET;
+	} else {
+		Task->State = TASK_STATE_WAITING;
+		Event->Waiter = Task;
+		ret = RESET;
+	}
+	__set_PRIMASK(primask);
+	return ret;
+}
+
+/*********************************************************************//**
+ * @brief 		Signal an event, may be called from interrupt. Queues the
+ * 				waiting task, or keeps the signal pending if none waits.
+ * @param[in]	Event	Pointer to a TASK_EVENT_Type event
+ * @param[in]	result	Value passed to the task in Task->Result
+ * @return 		None
+ **********************************************************************/
+void TASK_Signal(TASK_EVENT_Type *Event, uint32_t result)
+{
+	uint32_t primask = __get_PRIMASK();
+	TASK_Type *Task;
+
+	__disable_irq();
+	Task = Event->Waiter;
+	if (Task != NULL) {
+		Event->Waiter = NULL;
+		Task->Result = result;
+		TASK_Push(Task);
+	} else {
+		Event->Result = result;
+		Event->Pending = 1;
+	}
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief 		Park a task for a number of ticks, use TASK_DELAY() instead
+ * @param[in]	Task	Pointer to a TASK_Type task
+ * @param[in]	ticks	Number of TASK_Tick() calls, 0 to only yield
+ * @return 		None
+ **********************************************************************/
+void TASK_Sleep(TASK_Type *Task, uint32_t ticks)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if (ticks == 0) {
+		TASK_Push(Task);
+	} else {
+		Task->Wake = TASK_Ticks + ticks;
+		Task->State = TASK_STATE_SLEEPING;
+	}
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief 		Advance the delay clock, should be called from
+ * 				SysTick_Handler() or a timer match interrupt
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void TASK_Tick(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t i, now;
+
+	__disable_irq();
+	now = ++TASK_Ticks;
+	for (i = 0; i < TASK_MAX; i++) {
+		if ((TASK_Pool[i].State == TASK_STATE_SLEEPING) && ((int32_t)(now - TASK_Pool[i].Wake) >= 0)) {
+			TASK_Push(&TASK_Pool[i]);
+		}
+	}
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief 		Get the delay clock
+ * @param		None
+ * @return 		Number of TASK_Tick() calls
+ **********************************************************************/
+uint32_t TASK_GetTicks(void)
+{
+	return TASK_Ticks;
+}
+
+/*********************************************************************//**
+ * @brief 		Run the task at the head of the ready queue until its
+ * 				next await
+ * @param		None
+ * @return 		SET if a task was run, RESET if none was ready
+ **********************************************************************/
+FlagStatus TASK_Poll(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	TASK_Type *Task;
+
+	__disable_irq();
+	Task = TASK_ReadyHead;
+	if (Task != NULL) {
+		TASK_ReadyHead = Task->Next;
+		if (TASK_ReadyHead == NULL) {
+			TASK_ReadyTail = NULL;
+		}
+		Task->State = TASK_STATE_RUNNING;
+	}
+	__set_PRIMASK(primask);
+
+	if (Task == NULL) {
+		return RESET;
+	}
+	if (Task->Func(Task) == TASK_DONE) {
+		Task->State = TASK_STATE_FREE;
+	}
+	return SET;
+}
+
+/*********************************************************************//**
+ * @brief 		Run tasks forever, sleeping with WFI while none is ready
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void TASK_Run(void)
+{
+	for (;;) {
+		if (TASK_Poll() == RESET) {
+			/* WFI still wakes on a pending interrupt with PRIMASK set,
+			 * so a signal between the check and WFI is not lost */
+			__disable_irq();
+			if (TASK_ReadyHead == NULL) {
+				__WFI();
+			}
+			__enable_irq();
+		}
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Enable/Disable handling of a DMA channel's interrupts by
+ * 				TASK_DMAHandler()
+ * @param[in]	channel		DMA channel, should be in range from 0 to 7
+ * @param[in]	NewState	New State, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void TASK_DMACmd(uint8_t channel, FunctionalState NewState)
+{
+	if (NewState == ENABLE) {
+		TASK_DMAEvent[channel].Pending = 0;
+		TASK_DMABytes[channel] = 0;
+		TASK_DMAMask |= (1 << channel);
+	} else {
+		TASK_DMAMask &= ~(1 << channel);
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Enable a DMA channel set up with GPDMA_Setup(), recording
+ * 				the transfer for trace and DMA statistics. Await
+ * 				TASK_DMAEvent[channel] for its completion.
+ * @param[in]	channel		DMA channel, should be in range from 0 to 7
+ * @param[in]	bytes		Number of bytes moved by the transfer
+ * @return 		None
+ **********************************************************************/
+void TASK_DMAStart(uint8_t channel, uint32_t bytes)
+{
+	TASK_DMABytes[channel] = bytes;
+	TRACE_DMA_START(channel, bytes);
+	GPDMA_STATS_Start(channel);
+	GPDMA_ChannelCmd(channel, ENABLE);
+}
+
+/*********************************************************************//**
+ * @brief 		DMA handler, should be called from DMA_IRQHandler().
+ * 				Signals TASK_DMAEvent[] for the channels enabled with
+ * 				TASK_DMACmd(), other channels are left untouched.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void TASK_DMAHandler(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < 8; ch++) {
+		if (!(TASK_DMAMask & (1 << ch))) {
+			continue;
+		}
+		if (GPDMA_IntGetStatus(GPDMA_STAT_INTERR, ch)) {
+			GPDMA_ClearIntPending(GPDMA_STATCLR_INTERR, ch);
+			TRACE_DMA_ERR(ch);
+			GPDMA_STATS_Err(ch);
+			TASK_Signal(&TASK_DMAEvent[ch], ERROR);
+		} else if (GPDMA_IntGetStatus(GPDMA_STAT_INTTC, ch)) {
+			GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, ch);
+			TRACE_DMA_TC(ch);
+			GPDMA_STATS_TC(ch, TASK_DMABytes[ch]);
+			TASK_Signal(&TASK_DMAEvent[ch], SUCCESS);
+		}
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		ADC handler, should be called from ADC_IRQHandler() when
+ * 				converting without DMA, with the channel interrupt enabled
+ * 				by ADC_IntConfig(ADCx, ADC_ADINTENn, ENABLE). Reading the
+ * 				channel data register clears its DONE flag and the interrupt.
+ * @param[in]	ADCx	pointer to LPC_ADC_TypeDef, should be: LPC_ADC
+ * @param[in]	channel	ADC channel, should be in range from 0 to 7
+ * @return 		None
+ **********************************************************************/
+void TASK_ADCHandler(LPC_ADC_TypeDef *ADCx, uint8_t channel)
+{
+	TASK_Signal(&TASK_ADCEvent, ADC_ChannelGetData(ADCx, channel));
+}
+
+/*********************************************************************//**
+ * @brief 		External interrupt handler, should be called from
+ * 				EINTx_IRQHandler()
+ * @param[in]	EXTILine	external interrupt line, should be:
+ * 				- EXTI_EINT0: external interrupt line 0
+ * 				- EXTI_EINT1: external interrupt line 1
+ * 				- EXTI_EINT2: external interrupt line 2
+ * 				- EXTI_EINT3: external interrupt line 3
+ * @return 		None
+ **********************************************************************/
+void TASK_EINTHandler(EXTI_LINE_ENUM EXTILine)
+{
+	EXTI_ClearEXTIFlag(EXTILine);
+	TASK_Signal(&TASK_EINTEvent[EXTILine], 0);
+}
+
+/*********************************************************************//**
+ * @brief 		GPIO interrupt handler, should be called from
+ * 				EINT3_IRQHandler(). Edges on port 0 and 2 are cleared and
+ * 				accumulated into TASK_GPIOEvent[] until awaited.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void TASK_GPIOHandler(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t edges[2];
+	uint32_t i;
+
+	edges[0] = LPC_GPIOINT->IO0IntStatR | LPC_GPIOINT->IO0IntStatF;
+	LPC_GPIOINT->IO0IntClr = edges[0];
+	edges[1] = LPC_GPIOINT->IO2IntStatR | LPC_GPIOINT->IO2IntStatF;
+	LPC_GPIOINT->IO2IntClr = edges[1];
+
+	__disable_irq();
+	for (i = 0; i < 2; i++) {
+		if (edges[i]) {
+			if (TASK_GPIOEvent[i].Pending) {
+				edges[i] |= TASK_GPIOEvent[i].Result;
+			}
+			TASK_Signal(&TASK_GPIOEvent[i], edges[i]);
+		}
+	}
+	__set_PRIMASK(primask);
+}
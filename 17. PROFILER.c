@@ -0,0 +1,150 @@
+/* ########################## PROFILER — lpc17xx_profiler.h ########################## */
+
+/*
+ * Statistical PC sampling on the SysTick interrupt. With _PROFILE defined
+ * (see lpc17xx_libcfg.h) this module provides SysTick_Handler(): every
+ * Divider-th tick it records the PC and LR stacked by the interrupted
+ * context, then branches to PROFILE_TickHandler(), which the application
+ * defines in place of its own SysTick_Handler(). Code in interrupts of
+ * higher priority than SysTick is never sampled; raise the SysTick
+ * priority to profile them too.
+ *
+ * Dump:	(gdb) dump binary value prof.bin PROFILE_Buffer
+ * Report:	tools/profsym firmware.elf prof.bin
+ */
+
+#ifdef _PROFILE
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Number of samples kept in the ring, must be a power of 2 */
+#define PROFILE_BUFFER_SIZE		512
+/** Dump header magic, "PRF1" */
+#define PROFILE_MAGIC			0x31465250
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief Sample, 8 bytes */
+typedef struct {
+	uint32_t PC;			/**< Stacked return address of the interrupted code */
+	uint32_t LR;			/**< Stacked LR, caller of a leaf function */
+} PROFILE_Sample_Type;
+
+/** @brief Sample ring. Dumping this whole structure from a debugger gives
+ *  the file read by tools/profsym */
+typedef struct {
+	uint32_t Magic;			/**< PROFILE_MAGIC */
+	uint32_t Size;			/**< PROFILE_BUFFER_SIZE */
+	__IO uint32_t Head;		/**< Total number of samples recorded */
+	uint32_t Divider;		/**< SysTick interrupts per sample */
+	PROFILE_Sample_Type Samples[PROFILE_BUFFER_SIZE];
+} PROFILE_Buffer_Type;
+
+/* Public Variables ----------------------------------------------------------- */
+
+extern PROFILE_Buffer_Type PROFILE_Buffer;
+
+/* Private Variables ---------------------------------------------------------- */
+
+PROFILE_Buffer_Type PROFILE_Buffer;
+
+/** Ticks left before the next sample, 0 when stopped */
+static __IO uint32_t PROFILE_Countdown;
+
+/* Public Functions ----------------------------------------------------------- */
+
+/** Application tick code, called by SysTick_Handler() on every tick */
+extern void PROFILE_TickHandler(void);
+
+/*********************************************************************//**
+ * @brief 		Record one sample, called by SysTick_Handler() with the
+ * 				exception frame of the interrupted context. Costs a
+ * 				decrement on the ticks that are not sampled.
+ * @param[in]	frame	Stacked R0, R1, R2, R3, R12, LR, PC, xPSR
+ * @return 		None
+ **********************************************************************/
+void PROFILE_Record(uint32_t *frame)
+{
+	PROFILE_Sample_Type *s;
+
+	if ((PROFILE_Countdown == 0) || (--PROFILE_Countdown != 0)) {
+		return;
+	}
+	PROFILE_Countdown = PROFILE_Buffer.Divider;
+
+	/* SysTick does not nest with itself, no claim needed */
+	s = &PROFILE_Buffer.Samples[PROFILE_Buffer.Head & (PROFILE_BUFFER_SIZE - 1)];
+	s->PC = frame[6];
+	s->LR = frame[5];
+	PROFILE_Buffer.Head++;
+}
+
+/*
+ * EXC_RETURN bit 2 tells which stack holds the frame. R0 is pushed along
+ * with LR to keep the stack 8-byte aligned for the call.
+ */
+#if defined(__GNUC__)
+void SysTick_Handler(void) __attribute__((naked));
+void SysTick_Handler(void)
+{
+	__ASM volatile (
+		"tst	lr, #4\n"
+		"ite	eq\n"
+		"mrseq	r0, msp\n"
+		"mrsne	r0, psp\n"
+		"push	{r0, lr}\n"
+		"bl		PROFILE_Record\n"
+		"pop	{r0, lr}\n"
+		"b		PROFILE_TickHandler\n"
+	);
+}
+#elif defined(__CC_ARM)
+__asm void SysTick_Handler(void)
+{
+	IMPORT	PROFILE_Record
+	IMPORT	PROFILE_TickHandler
+	TST		LR, #4
+	ITE		EQ
+	MRSEQ	R0, MSP
+	MRSNE	R0, PSP
+	PUSH	{R0, LR}
+	BL		PROFILE_Record
+	POP		{R0, LR}
+	B		PROFILE_TickHandler
+}
+#else
+#error "PROFILER: SysTick_Handler() not available for this compiler"
+#endif
+
+/*********************************************************************//**
+ * @brief 		Initial profiler, SYSTICK_InternalInit() sets the tick
+ * 				period. Sample rate is the tick rate divided by divider;
+ * 				overhead is one SysTick_Handler() entry per tick plus about
+ * 				20 cycles per sample.
+ * @param[in]	divider		SysTick interrupts per sample, should be 1 or more
+ * @return 		None
+ **********************************************************************/
+void PROFILE_Init(uint32_t divider)
+{
+	CHECK_PARAM(divider != 0);
+
+	PROFILE_Countdown = 0;
+	PROFILE_Buffer.Magic = PROFILE_MAGIC;
+	PROFILE_Buffer.Size = PROFILE_BUFFER_SIZE;
+	PROFILE_Buffer.Divider = divider;
+	PROFILE_Buffer.Head = 0;
+}
+
+/*********************************************************************//**
+ * @brief 		Start/Stop sampling. The ring is kept when stopped.
+ * @param[in]	NewState	New State of profiler, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void PROFILE_Cmd(FunctionalState NewState)
+{
+	PROFILE_Countdown = (NewState == ENABLE) ? PROFILE_Buffer.Divider : 0;
+}
+
+#endif /* _PROFILE */
@@ -0,0 +1,250 @@
+/* ########################## COUNTER — lpc17xx_counter.h ########################## */
+
+/*
+ * Pulse counting in TIMER counter mode. Edges are counted by the timer
+ * hardware on a CAPn.x pin, with no interrupt per edge; the input rate is
+ * limited to PCLK/4. A gate timer interrupts once per gate period and
+ * samples all counters back-to-back. Counters are never reset, so no edge
+ * is lost between gates. Rates are scaled by the DWT cycles actually
+ * elapsed between samples, so interrupt latency does not bias them.
+ */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Maximum number of counters sampled by the gate */
+#define COUNTER_MAX				3
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief Counter input configuration structure */
+typedef struct {
+	LPC_TIM_TypeDef *TIMx;	/**< Counting timer, LPC_TIM0..3, not the gate timer */
+	uint8_t Mode;			/**< Edges counted, should be:
+							- TIM_COUNTER_RISING_MODE
+							- TIM_COUNTER_FALLING_MODE
+							- TIM_COUNTER_ANY_MODE */
+	uint8_t Input;			/**< Count input, should be:
+							- TIM_COUNTER_INCAP0: CAPn.0 input pin for TIMERn
+							- TIM_COUNTER_INCAP1: CAPn.1 input pin for TIMERn */
+	uint8_t Reserved[2];
+} COUNTER_CFG_Type;
+
+/** @brief Counter. With a down channel the result is up minus down, for
+ *  flow meters and encoders with separate forward/reverse pulse outputs
+ *  or behind a quadrature to up/down decoder. Allocate statically */
+typedef struct {
+	LPC_TIM_TypeDef *UpTIMx;
+	LPC_TIM_TypeDef *DownTIMx;		/**< NULL for a single channel */
+	uint32_t UpLast;				/**< Up timer TC at the previous gate */
+	uint32_t DownLast;				/**< Down timer TC at the previous gate */
+	__IO int32_t Count;				/**< Net edges in the last gate period */
+	__IO int32_t Rate;				/**< Net edges per second in the last gate period */
+	__IO int64_t Total;				/**< Net edges since COUNTER_Init() */
+	__IO uint32_t Gates;			/**< Number of gate periods sampled */
+} COUNTER_Type;
+
+/* Private Variables ---------------------------------------------------------- */
+
+static LPC_TIM_TypeDef *COUNTER_GateTIMx;
+static COUNTER_Type *COUNTER_List[COUNTER_MAX];
+static uint8_t COUNTER_Num;
+/** DWT cycle counter at the previous gate */
+static uint32_t COUNTER_GateStamp;
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Configure a timer in counter mode and start it
+ * @param[in]	CounterCfg	Pointer to a COUNTER_CFG_Type structure
+ * @return 		None
+ **********************************************************************/
+static void COUNTER_Start(COUNTER_CFG_Type *CounterCfg)
+{
+	TIM_COUNTERCFG_Type TIMCfg;
+
+	TIMCfg.CounterOption = CounterCfg->Input;
+	TIMCfg.CountInputSelect = CounterCfg->Input;
+	TIM_Init(CounterCfg->TIMx, (TIM_MODE_OPT)CounterCfg->Mode, &TIMCfg);
+	TIM_Cmd(CounterCfg->TIMx, ENABLE);
+}
+
+/*********************************************************************//**
+ * @brief 		Check whether a timer is already used by the gate or by a
+ * 				counter added before
+ * @param[in]	TIMx	Timer peripheral
+ * @return 		SET if the timer is in use, RESET otherwise
+ **********************************************************************/
+static FlagStatus COUNTER_TimerInUse(LPC_TIM_TypeDef *TIMx)
+{
+	uint8_t i;
+
+	if (TIMx == COUNTER_GateTIMx) {
+		return SET;
+	}
+	for (i = 0; i < COUNTER_Num; i++) {
+		if ((COUNTER_List[i]->UpTIMx == TIMx) || (COUNTER_List[i]->DownTIMx == TIMx)) {
+			return SET;
+		}
+	}
+	return RESET;
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Initial gate timer, interrupting once per gate period.
+ * 				Enables the DWT cycle counter used to measure the period.
+ * @param[in]	TIMx	Gate timer, should be:
+ * 				- LPC_TIM0: TIMER0 peripheral
+ * 				- LPC_TIM1: TIMER1 peripheral
+ * 				- LPC_TIM2: TIMER2 peripheral
+ * 				- LPC_TIM3: TIMER3 peripheral
+ * @param[in]	period	Gate period (us), at most 7/8 of 2^32 core cycles
+ * 						(about 37 s at 100 MHz) so the DWT cycle counter
+ * 						does not wrap within a period
+ * @return 		ERROR if period is 0 or too long, SUCCESS otherwise
+ **********************************************************************/
+Status COUNTER_GateInit(LPC_TIM_TypeDef *TIMx, uint32_t period)
+{
+	TIM_TIMERCFG_Type TIMCfg;
+	TIM_MATCHCFG_Type MatchCfg;
+
+	/* Keep 1/8 of the DWT range as margin for gate interrupt latency */
+	if ((period == 0) || ((uint64_t)period * SystemCoreClock > 1000000ULL * 0xE0000000UL)) {
+		return ERROR;
+	}
+
+	TRACE_CycleCounterInit();
+
+	COUNTER_GateTIMx = TIMx;
+	COUNTER_Num = 0;
+
+	TIMCfg.PrescaleOption = TIM_PRESCALE_USVAL;
+	TIMCfg.PrescaleValue = 1;
+	TIM_Init(TIMx, TIM_TIMER_MODE, &TIMCfg);
+	MatchCfg.MatchChannel = 0;
+	MatchCfg.IntOnMatch = ENABLE;
+	MatchCfg.ResetOnMatch = ENABLE;
+	MatchCfg.StopOnMatch = DISABLE;
+	MatchCfg.ExtMatchOutputType = TIM_EXTMATCH_NOTHING;
+	MatchCfg.MatchValue = period;
+	TIM_ConfigMatch(TIMx, &MatchCfg);
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Initial a counter and add it to the gate. Counting starts
+ * 				immediately; COUNTER_GateInit() must have been called before.
+ * @param[in]	Counter		Pointer to a COUNTER_Type counter
+ * @param[in]	UpCfg		Pointer to a COUNTER_CFG_Type structure, edges
+ * 							counted up
+ * @param[in]	DownCfg		Pointer to a COUNTER_CFG_Type structure, edges
+ * 							counted down, NULL for a single channel
+ * @return 		ERROR if COUNTER_MAX counters are already added, if up and
+ * 				down use the same timer or if a timer is the gate timer or
+ * 				is used by another counter, SUCCESS otherwise
+ **********************************************************************/
+Status COUNTER_Init(COUNTER_Type *Counter, COUNTER_CFG_Type *UpCfg, COUNTER_CFG_Type *DownCfg)
+{
+	uint32_t primask;
+
+	if ((COUNTER_Num >= COUNTER_MAX) || (COUNTER_TimerInUse(UpCfg->TIMx) == SET)) {
+		return ERROR;
+	}
+	if ((DownCfg != NULL) && ((DownCfg->TIMx == UpCfg->TIMx)
+			|| (COUNTER_TimerInUse(DownCfg->TIMx) == SET))) {
+		return ERROR;
+	}
+
+	Counter->UpTIMx = UpCfg->TIMx;
+	Counter->DownTIMx = (DownCfg != NULL) ? DownCfg->TIMx : NULL;
+	Counter->UpLast = 0;
+	Counter->DownLast = 0;
+	Counter->Count = 0;
+	Counter->Rate = 0;
+	Counter->Total = 0;
+	Counter->Gates = 0;
+
+	COUNTER_Start(UpCfg);
+	if (DownCfg != NULL) {
+		COUNTER_Start(DownCfg);
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	COUNTER_List[COUNTER_Num++] = Counter;
+	__set_PRIMASK(primask);
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Start/Stop the gate. Counters keep counting while the gate
+ * 				is stopped; the first period after a restart is longer.
+ * @param[in]	NewState	New State of gate, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void COUNTER_GateCmd(FunctionalState NewState)
+{
+	if (NewState == ENABLE) {
+		COUNTER_GateStamp = DWT->CYCCNT;
+	}
+	TIM_Cmd(COUNTER_GateTIMx, NewState);
+}
+
+/*********************************************************************//**
+ * @brief 		Get a consistent copy of a counter's total
+ * @param[in]	Counter		Pointer to a COUNTER_Type counter
+ * @return 		Net edges since COUNTER_Init(), up to the last gate
+ **********************************************************************/
+int64_t COUNTER_GetTotal(COUNTER_Type *Counter)
+{
+	uint32_t primask = __get_PRIMASK();
+	int64_t total;
+
+	__disable_irq();
+	total = Counter->Total;
+	__set_PRIMASK(primask);
+	return total;
+}
+
+/*********************************************************************//**
+ * @brief 		Gate handler, should be called from the gate timer
+ * 				TIMERn_IRQHandler(). Samples all counters and updates
+ * 				Count, Rate, Total and Gates.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void COUNTER_GateHandler(void)
+{
+	uint32_t up[COUNTER_MAX], down[COUNTER_MAX];
+	uint32_t now, cycles;
+	uint8_t i;
+
+	TIM_ClearIntPending(COUNTER_GateTIMx, TIM_MR0_INT);
+
+	/* Read all counters first so they share one sampling instant */
+	for (i = 0; i < COUNTER_Num; i++) {
+		up[i] = COUNTER_List[i]->UpTIMx->TC;
+		down[i] = (COUNTER_List[i]->DownTIMx != NULL) ? COUNTER_List[i]->DownTIMx->TC : 0;
+	}
+	now = DWT->CYCCNT;
+	cycles = now - COUNTER_GateStamp;
+	COUNTER_GateStamp = now;
+
+	for (i = 0; i < COUNTER_Num; i++) {
+		COUNTER_Type *Counter = COUNTER_List[i];
+		int32_t count;
+
+		/* Free running 32-bit counters, wrap is handled by the subtraction */
+		count = (int32_t)(up[i] - Counter->UpLast) - (int32_t)(down[i] - Counter->DownLast);
+		Counter->UpLast = up[i];
+		Counter->DownLast = down[i];
+
+		Counter->Count = count;
+		Counter->Total += count;
+		Counter->Rate = (cycles != 0) ? (int32_t)(((int64_t)count * SystemCoreClock) / cycles) : 0;
+		Counter->Gates++;
+	}
+}
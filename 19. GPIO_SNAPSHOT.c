@@ -0,0 +1,125 @@
+/* ########################## GPIO SNAPSHOT — lpc17xx_gpio_snapshot.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Number of GPIO ports */
+#define GPIO_SNAPSHOT_NUM_PORTS		5
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief Pin levels of all ports taken at one instant, index is port number */
+typedef struct {
+	uint32_t Pin[GPIO_SNAPSHOT_NUM_PORTS];
+} GPIO_SNAPSHOT_Type;
+
+/** @brief Change callback, called once per scan with all changed pins.
+ *  Rising pins are Changed & Now->Pin, falling pins Changed & ~Now->Pin */
+typedef void (*GPIO_SNAPSHOT_Callback_Type)(const GPIO_SNAPSHOT_Type *Now, const GPIO_SNAPSHOT_Type *Changed);
+
+/** @brief Scanner configuration structure */
+typedef struct {
+	uint32_t Mask[GPIO_SNAPSHOT_NUM_PORTS];	/**< Pins watched on each port, 0 for none */
+	GPIO_SNAPSHOT_Callback_Type Callback;	/**< Change callback */
+} GPIO_SNAPSHOT_CFG_Type;
+
+/** @brief Scanner state. Allocate statically */
+typedef struct {
+	GPIO_SNAPSHOT_Type Mask;
+	GPIO_SNAPSHOT_Type Last;			/**< Snapshot of the previous scan */
+	GPIO_SNAPSHOT_Callback_Type Callback;
+	uint32_t Changes;					/**< Number of scans that found a change */
+} GPIO_SNAPSHOT_SCAN_Type;
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Read all ports back-to-back with interrupts masked, so the
+ * 				levels are consistent across ports. Pins outside the mask
+ * 				read as 0.
+ * @param[in]	Mask		Pointer to a GPIO_SNAPSHOT_Type with the pins to
+ * 							keep on each port
+ * @param[out]	Snapshot	Pointer to a GPIO_SNAPSHOT_Type receiving the levels
+ * @return 		None
+ **********************************************************************/
+void GPIO_SNAPSHOT_Read(const GPIO_SNAPSHOT_Type *Mask, GPIO_SNAPSHOT_Type *Snapshot)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t p0, p1, p2, p3, p4;
+
+	/* Five loads from the AHB GPIO block, a few cycles apart */
+	__disable_irq();
+	p0 = LPC_GPIO0->FIOPIN;
+	p1 = LPC_GPIO1->FIOPIN;
+	p2 = LPC_GPIO2->FIOPIN;
+	p3 = LPC_GPIO3->FIOPIN;
+	p4 = LPC_GPIO4->FIOPIN;
+	__set_PRIMASK(primask);
+
+	Snapshot->Pin[0] = p0 & Mask->Pin[0];
+	Snapshot->Pin[1] = p1 & Mask->Pin[1];
+	Snapshot->Pin[2] = p2 & Mask->Pin[2];
+	Snapshot->Pin[3] = p3 & Mask->Pin[3];
+	Snapshot->Pin[4] = p4 & Mask->Pin[4];
+}
+
+/*********************************************************************//**
+ * @brief 		Compare two snapshots
+ * @param[in]	Old			Pointer to the older GPIO_SNAPSHOT_Type
+ * @param[in]	New			Pointer to the newer GPIO_SNAPSHOT_Type
+ * @param[out]	Changed		Pointer to a GPIO_SNAPSHOT_Type receiving the
+ * 							pins that differ on each port
+ * @return 		SET if any pin differs, RESET otherwise
+ **********************************************************************/
+FlagStatus GPIO_SNAPSHOT_Diff(const GPIO_SNAPSHOT_Type *Old, const GPIO_SNAPSHOT_Type *New, GPIO_SNAPSHOT_Type *Changed)
+{
+	uint32_t any = 0;
+	uint8_t i;
+
+	for (i = 0; i < GPIO_SNAPSHOT_NUM_PORTS; i++) {
+		Changed->Pin[i] = Old->Pin[i] ^ New->Pin[i];
+		any |= Changed->Pin[i];
+	}
+	return any ? SET : RESET;
+}
+
+/*********************************************************************//**
+ * @brief 		Initial scanner and take its first snapshot, without
+ * 				notification. Pins should be set as inputs before.
+ * @param[in]	Scan		Pointer to a GPIO_SNAPSHOT_SCAN_Type scanner
+ * @param[in]	ScanCfg		Pointer to a GPIO_SNAPSHOT_CFG_Type structure
+ * @return 		None
+ **********************************************************************/
+void GPIO_SNAPSHOT_Init(GPIO_SNAPSHOT_SCAN_Type *Scan, GPIO_SNAPSHOT_CFG_Type *ScanCfg)
+{
+	uint8_t i;
+
+	for (i = 0; i < GPIO_SNAPSHOT_NUM_PORTS; i++) {
+		Scan->Mask.Pin[i] = ScanCfg->Mask[i];
+	}
+	Scan->Callback = ScanCfg->Callback;
+	Scan->Changes = 0;
+	GPIO_SNAPSHOT_Read(&Scan->Mask, &Scan->Last);
+}
+
+/*********************************************************************//**
+ * @brief 		Take a snapshot, compare it with the previous one and call
+ * 				the callback once if any watched pin changed. May be called
+ * 				from a periodic timer interrupt or the main loop.
+ * @param[in]	Scan		Pointer to a GPIO_SNAPSHOT_SCAN_Type scanner
+ * @return 		SET if a change was notified, RESET otherwise
+ **********************************************************************/
+FlagStatus GPIO_SNAPSHOT_Scan(GPIO_SNAPSHOT_SCAN_Type *Scan)
+{
+	GPIO_SNAPSHOT_Type now, changed;
+
+	GPIO_SNAPSHOT_Read(&Scan->Mask, &now);
+	if (GPIO_SNAPSHOT_Diff(&Scan->Last, &now, &changed) == RESET) {
+		return RESET;
+	}
+	Scan->Last = now;
+	Scan->Changes++;
+	if (Scan->Callback != NULL) {
+		Scan->Callback(&now, &changed);
+	}
+	return SET;
+}
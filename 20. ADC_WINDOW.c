@@ -0,0 +1,229 @@
+/* ########################## ADC WINDOW — lpc17xx_adc_window.h ########################## */
+
+/*
+ * Window comparator run over ADC blocks moved by DMA from ADGDR, so the
+ * CPU wakes once per block instead of once per conversion. The scan
+ * only leaves its inner loop when a sample falls outside the band of the
+ * current state, and an event is raised only when a new state has held
+ * for MinDuration samples.
+ */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Window states and event types */
+#define ADC_WINDOW_INSIDE		0	/**< Low <= sample <= High */
+#define ADC_WINDOW_ABOVE		1	/**< sample > High */
+#define ADC_WINDOW_BELOW		2	/**< sample < Low */
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief Window event */
+typedef struct {
+	uint8_t Type;			/**< State entered, ADC_WINDOW_x */
+	uint8_t Channel;		/**< ADC channel */
+	uint16_t Value;			/**< First sample of the new state, 12 bits */
+	uint32_t SampleIndex;	/**< Index of that sample since ADC_WINDOW_Init() */
+	uint32_t Timestamp;		/**< DWT cycle counter at that sample */
+} ADC_WINDOW_EVENT_Type;
+
+struct ADC_WINDOW_Struct;
+
+/** @brief Event callback, called from the context of ADC_WINDOW_Process() */
+typedef void (*ADC_WINDOW_Callback_Type)(struct ADC_WINDOW_Struct *Window, const ADC_WINDOW_EVENT_Type *Event);
+
+/** @brief Window configuration structure */
+typedef struct {
+	uint8_t Channel;		/**< ADC channel, should be in range from 0 to 7 */
+	uint8_t Reserved;
+	uint16_t Low;			/**< Lower limit, 0..4095 */
+	uint16_t High;			/**< Upper limit, Low..4095 */
+	uint16_t Hysteresis;	/**< Distance a sample must come back inside a
+							limit to leave the ABOVE/BELOW state, at
+							most High - Low */
+	uint32_t MinDuration;	/**< Samples a new state must hold before its
+							event is raised, 1 for immediate */
+	uint32_t SamplePeriod;	/**< DWT cycles between two samples of this
+							channel, used to timestamp events */
+	ADC_WINDOW_Callback_Type Callback;	/**< Event callback */
+} ADC_WINDOW_CFG_Type;
+
+/** @brief Window detector, one per channel. Allocate statically */
+typedef struct ADC_WINDOW_Struct {
+	ADC_WINDOW_Callback_Type Callback;
+	uint32_t MinDuration;
+	uint32_t SamplePeriod;
+	uint16_t Low;
+	uint16_t High;
+	uint16_t Hysteresis;
+	uint8_t Channel;
+	uint8_t State;					/**< ADC_WINDOW_x, state last reported */
+	uint8_t Candidate;				/**< State being qualified, equal to
+									State when none */
+	uint8_t Reserved;
+	uint16_t CandidateValue;		/**< First sample of the candidate run */
+	uint32_t CandidateIndex;		/**< Index of that sample */
+	uint32_t CandidateStamp;		/**< Timestamp of that sample */
+	uint32_t Run;					/**< Samples in the candidate run */
+	uint32_t SampleIndex;			/**< Samples processed */
+	__IO uint32_t Events;			/**< Events raised */
+} ADC_WINDOW_Type;
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Band of samples that keep the current state
+ * @param[in]	Window	Pointer to a ADC_WINDOW_Type detector
+ * @param[out]	lo		Lowest sample in the band
+ * @param[out]	hi		Highest sample in the band
+ * @return 		None
+ **********************************************************************/
+static void ADC_WINDOW_Band(ADC_WINDOW_Type *Window, uint32_t *lo, uint32_t *hi)
+{
+	switch (Window->State) {
+	case ADC_WINDOW_ABOVE:
+		*lo = (Window->High > Window->Hysteresis) ? (Window->High - Window->Hysteresis) : 0;
+		*hi = 0xFFF;
+		break;
+	case ADC_WINDOW_BELOW:
+		*lo = 0;
+		*hi = Window->Low + Window->Hysteresis;
+		break;
+	default:
+		*lo = Window->Low;
+		*hi = Window->High;
+		break;
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		State a sample outside the current band belongs to
+ * @param[in]	Window	Pointer to a ADC_WINDOW_Type detector
+ * @param[in]	value	12-bit sample
+ * @return 		ADC_WINDOW_x
+ **********************************************************************/
+static uint8_t ADC_WINDOW_Zone(ADC_WINDOW_Type *Window, uint32_t value)
+{
+	if (value > Window->High) {
+		return ADC_WINDOW_ABOVE;
+	}
+	if (value < Window->Low) {
+		return ADC_WINDOW_BELOW;
+	}
+	/* Within the limits, past the hysteresis band of ABOVE/BELOW */
+	return ADC_WINDOW_INSIDE;
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Initial window detector, state starts INSIDE
+ * @param[in]	Window		Pointer to a ADC_WINDOW_Type detector
+ * @param[in]	WindowCfg	Pointer to a ADC_WINDOW_CFG_Type structure
+ * @return 		ERROR if High < Low, Hysteresis > High - Low or MinDuration
+ * 				is 0, SUCCESS otherwise
+ **********************************************************************/
+Status ADC_WINDOW_Init(ADC_WINDOW_Type *Window, ADC_WINDOW_CFG_Type *WindowCfg)
+{
+	/* A wider hysteresis would let the ABOVE and BELOW bands overlap */
+	if ((WindowCfg->High < WindowCfg->Low) || (WindowCfg->MinDuration == 0)
+			|| (WindowCfg->Hysteresis > WindowCfg->High - WindowCfg->Low)) {
+		return ERROR;
+	}
+	Window->Callback = WindowCfg->Callback;
+	Window->MinDuration = WindowCfg->MinDuration;
+	Window->SamplePeriod = WindowCfg->SamplePeriod;
+	Window->Low = WindowCfg->Low;
+	Window->High = WindowCfg->High;
+	Window->Hysteresis = WindowCfg->Hysteresis;
+	Window->Channel = WindowCfg->Channel;
+	Window->State = ADC_WINDOW_INSIDE;
+	Window->Candidate = ADC_WINDOW_INSIDE;
+	Window->Run = 0;
+	Window->SampleIndex = 0;
+	Window->Events = 0;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Scan one DMA block of ADGDR words, should be called from
+ * 				the ADC DMA terminal count handler. With several channels
+ * 				in burst mode the block interleaves them; pass the first
+ * 				word of this channel and the number of channels as stride,
+ * 				with a block size that is a multiple of the stride.
+ * @param[in]	Window		Pointer to a ADC_WINDOW_Type detector
+ * @param[in]	block		First ADGDR word of this channel in the block
+ * @param[in]	count		Number of samples of this channel in the block
+ * @param[in]	stride		Words between two samples of this channel
+ * @param[in]	stamp		DWT cycle counter at the last sample, usually
+ * 							read at the DMA terminal count
+ * @return 		ERROR if the first word is from another channel (block
+ * 				not aligned, nothing scanned), SUCCESS otherwise
+ **********************************************************************/
+Status ADC_WINDOW_Process(ADC_WINDOW_Type *Window, const uint32_t *block, uint32_t count,
+		uint32_t stride, uint32_t stamp)
+{
+	ADC_WINDOW_EVENT_Type ev;
+	uint32_t lo, hi, i, value;
+	uint8_t zone;
+
+	if ((count == 0) || (ADC_GDR_CH(block[0]) != Window->Channel)) {
+		return ERROR;
+	}
+
+	ADC_WINDOW_Band(Window, &lo, &hi);
+	for (i = 0; i < count; i++) {
+		if (Window->Candidate == Window->State) {
+			/* Nothing pending: skip in-band samples, one compare each */
+			while ((i < count) && ((ADC_DR_RESULT(block[i * stride]) - lo) <= (hi - lo))) {
+				i++;
+			}
+			if (i == count) {
+				break;
+			}
+		}
+
+		value = ADC_DR_RESULT(block[i * stride]);
+		if ((value - lo) <= (hi - lo)) {
+			/* Back in band, candidate run broken */
+			Window->Candidate = Window->State;
+			continue;
+		}
+
+		zone = ADC_WINDOW_Zone(Window, value);
+		if (zone != Window->Candidate) {
+			Window->Candidate = zone;
+			Window->CandidateValue = (uint16_t)value;
+			Window->CandidateIndex = Window->SampleIndex + i;
+			Window->CandidateStamp = stamp - (count - 1 - i) * Window->SamplePeriod;
+			Window->Run = 0;
+		}
+		if (++Window->Run < Window->MinDuration) {
+			continue;
+		}
+
+		Window->State = Window->Candidate;
+		Window->Events++;
+		ADC_WINDOW_Band(Window, &lo, &hi);
+
+		ev.Type = Window->State;
+		ev.Channel = Window->Channel;
+		ev.Value = Window->CandidateValue;
+		ev.SampleIndex = Window->CandidateIndex;
+		ev.Timestamp = Window->CandidateStamp;
+		if (Window->Callback != NULL) {
+			Window->Callback(Window, &ev);
+		}
+	}
+	Window->SampleIndex += count;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Get current window state
+ * @param[in]	Window		Pointer to a ADC_WINDOW_Type detector
+ * @return 		ADC_WINDOW_INSIDE, ADC_WINDOW_ABOVE or ADC_WINDOW_BELOW
+ **********************************************************************/
+uint8_t ADC_WINDOW_GetState(ADC_WINDOW_Type *Window)
+{
+	return Window->State;
+}
@@ -133,6 +133,9 @@ void TIM_ClearIntPending(LPC_TIM_TypeDef *TIMx, TIM_INT_TYPE IntFlag)
     CHECK_PARAM(PARAM_TIMx(TIMx));
     CHECK_PARAM(PARAM_TIM_INT_TYPE(IntFlag));
     TIMx->IR |= TIM_IR_CLR(IntFlag);
+    if (IntFlag <= TIM_MR3_INT) {
+        TRACE_TIM_MATCH(TIMx, IntFlag);
+    }
 }
 
 /*********************************************************************//**
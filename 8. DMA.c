@@ -78,6 +78,17 @@ typedef struct {
 	uint32_t Control;	/**< GPDMA Control of this LLI */
 } GPDMA_LLI_Type;
 
+/* Public Variables ----------------------------------------------------------- */
+
+/** Channel registers indexed by channel number, for drivers that adjust a
+ *  channel after GPDMA_Setup() */
+extern LPC_GPDMACH_TypeDef * const GPDMA_Channel[8];
+
+LPC_GPDMACH_TypeDef * const GPDMA_Channel[8] = {
+	LPC_GPDMACH0, LPC_GPDMACH1, LPC_GPDMACH2, LPC_GPDMACH3,
+	LPC_GPDMACH4, LPC_GPDMACH5, LPC_GPDMACH6, LPC_GPDMACH7,
+};
+
 /* Public Functions ----------------------------------------------------------- */
 
 /********************************************************************//**
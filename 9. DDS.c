@@ -0,0 +1,479 @@
+/* ########################## DDS — lpc17xx_dds.h ########################## */
+
+/* Public Macros -------------------------------------------------------------- */
+
+/** Number of samples in each DAC DMA block. A retune takes effect at the next
+ *  block boundary, so this is also the worst case retune latency in samples */
+#define DDS_BLOCK_SIZE			128
+/** Full scale amplitude (Q15) */
+#define DDS_AMPLITUDE_FULL		0x7FFF
+/** DAC mid-scale code, DC level of the generated waveform */
+#define DDS_DAC_MIDSCALE		512
+
+/* Structures ----------------------------------------------------------------- */
+
+/** @brief DDS configuration structure */
+typedef struct {
+	uint32_t ChannelNum;	/**< DMA channel used to feed the DAC, should be in
+							range from 0 to 7 */
+	uint32_t SampleRate;	/**< DAC update rate (Hz), should be <= 1MHz. The
+							nearest rate of a whole number of DAC clocks,
+							at most 0xFFFF, is used */
+	uint32_t Frequency;		/**< Initial output frequency (Hz) */
+	uint32_t Amplitude;		/**< Initial amplitude, Q15 in range from 0 to
+							DDS_AMPLITUDE_FULL */
+	uint32_t Phase;			/**< Initial phase offset, 0..0xFFFFFFFF maps to 0..360 deg */
+} DDS_CFG_Type;
+
+/** @brief DDS generator state, owned by the DMA interrupt once started */
+typedef struct {
+	uint32_t Accumulator;			/**< 32-bit phase accumulator */
+	uint32_t PhaseInc;				/**< Tuning word of the current block */
+	uint32_t Amplitude;				/**< Amplitude of the current block (Q15) */
+	uint32_t Phase;					/**< Phase offset of the current block */
+	__IO uint32_t NextPhaseInc;		/**< Tuning word latched at next block */
+	__IO uint32_t NextAmplitude;	/**< Amplitude latched at next block */
+	__IO uint32_t NextPhase;		/**< Phase offset latched at next block */
+	__IO uint8_t PhaseIncPending;	/**< Set by thread, cleared by DMA interrupt */
+	__IO uint8_t AmplitudePending;
+	__IO uint8_t PhasePending;
+	__IO uint8_t SweepEnable;		/**< ENABLE: add SweepStep to tuning word every block */
+	uint32_t SweepStart;			/**< Tuning word at which a sweep restarts */
+	uint32_t SweepStop;				/**< Tuning word at which a sweep wraps around */
+	int32_t SweepStep;				/**< Tuning word increment per block */
+	__IO uint8_t FSKEnable;			/**< ENABLE: tuning word follows the FSK symbols */
+	uint8_t FSKBitsLeft;			/**< Symbols left in FSKShift */
+	__IO uint8_t FSKNextBits;		/**< Symbols queued in FSKNext, 0 if empty */
+	uint8_t Active;					/**< Index of the buffer DMA is reading */
+	uint32_t FSKMark;				/**< Tuning word for symbol '1' */
+	uint32_t FSKSpace;				/**< Tuning word for symbol '0' */
+	uint32_t FSKSymbolInc;			/**< Symbol phase increment per sample,
+									baudrate * 2^32 / SampleRate, 0 if not configured */
+	uint32_t FSKSymbolPhase;		/**< Symbol phase at the end of the current symbol */
+	uint32_t FSKSymbolLeft;			/**< Samples left in the current symbol */
+	uint32_t FSKShift;				/**< Symbols being sent, LSB first */
+	__IO uint32_t FSKNext;			/**< Symbols queued by DDS_FSKSend() */
+	uint32_t SampleRate;			/**< Actual DAC update rate (Hz), rounded down */
+	uint32_t SampleTicks;			/**< DAC clocks per sample */
+	uint32_t DACClock;				/**< DAC peripheral clock (Hz) */
+	uint32_t ChannelNum;
+} DDS_Type;
+
+/* Private Variables ---------------------------------------------------------- */
+
+/** Quarter sine wave, 65 points, Q15 */
+static const int16_t DDS_SineTable[65] = {
+	0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+	6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+	12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+	18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+	23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+	27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+	30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+	32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+	32767,
+};
+
+static DDS_Type DDS;
+static uint32_t DDS_Buffer[2][DDS_BLOCK_SIZE];
+static GPDMA_LLI_Type DDS_LLI[2];
+
+/* Private Functions ---------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Convert a frequency to a tuning word
+ * @param[in]	freq	Frequency (Hz)
+ * @return 		Phase increment per sample, freq * 2^32 / SampleRate at
+ * 				the exact sample rate DACClock / SampleTicks
+ **********************************************************************/
+static uint32_t DDS_TuningWord(uint32_t freq)
+{
+	/* Only the fraction of a turn per sample matters, keep it below 2^32 */
+	uint64_t turns = ((uint64_t)freq * DDS.SampleTicks) % DDS.DACClock;
+
+	return (uint32_t)((turns << 32) / DDS.DACClock);
+}
+
+/*********************************************************************//**
+ * @brief 		Look up sin(phase) from the quarter wave table with
+ * 				linear interpolation
+ * @param[in]	phase	0..0xFFFFFFFF maps to 0..360 deg
+ * @return 		Sine value, Q15
+ **********************************************************************/
+static __INLINE int32_t DDS_Sine(uint32_t phase)
+{
+	uint32_t p = phase << 2;
+	uint32_t idx, frac;
+	int32_t s;
+
+	/* Second and fourth quadrant run the table backwards */
+	if (phase & 0x40000000) {
+		p = ~p;
+	}
+	idx = p >> 26;
+	frac = (p >> 18) & 0xFF;
+	s = DDS_SineTable[idx];
+	s += ((DDS_SineTable[idx + 1] - s) * (int32_t)frac) >> 8;
+
+	return (phase & 0x80000000) ? -s : s;
+}
+
+/*********************************************************************//**
+ * @brief 		Latch pending parameters and advance the sweep. Called
+ * 				once per block, before the block is generated. While FSK
+ * 				is enabled the tuning word belongs to the symbol being
+ * 				sent, so a pending frequency is kept until FSK is disabled.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void DDS_Latch(void)
+{
+	if (!DDS.FSKEnable) {
+		if (DDS.PhaseIncPending) {
+			DDS.PhaseIncPending = 0;
+			DDS.PhaseInc = DDS.NextPhaseInc;
+		} else if (DDS.SweepEnable) {
+			DDS.PhaseInc += DDS.SweepStep;
+			if (((DDS.SweepStep > 0) && (DDS.PhaseInc >= DDS.SweepStop))
+					|| ((DDS.SweepStep < 0) && (DDS.PhaseInc <= DDS.SweepStop))) {
+				DDS.PhaseInc = DDS.SweepStart;
+			}
+		}
+	}
+	if (DDS.AmplitudePending) {
+		DDS.AmplitudePending = 0;
+		DDS.Amplitude = DDS.NextAmplitude;
+	}
+	if (DDS.PhasePending) {
+		DDS.PhasePending = 0;
+		DDS.Phase = DDS.NextPhase;
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Generate one block of DACR words. Cost is a fixed number
+ * 				of cycles per sample, independent of the parameters
+ * @param[in]	block	Buffer of DDS_BLOCK_SIZE words
+ * @return 		None
+ **********************************************************************/
+static void DDS_FillBlock(uint32_t *block)
+{
+	uint32_t acc, inc, phase, amp, i, n;
+	int32_t s;
+
+	DDS_Latch();
+	acc = DDS.Accumulator;
+	inc = DDS.PhaseInc;
+	phase = DDS.Phase;
+	amp = DDS.Amplitude;
+
+	for (i = 0; i < DDS_BLOCK_SIZE; ) {
+		n = DDS_BLOCK_SIZE - i;
+		if (DDS.FSKEnable) {
+			if (DDS.FSKSymbolLeft == 0) {
+				if ((DDS.FSKBitsLeft == 0) && DDS.FSKNextBits) {
+					DDS.FSKShift = DDS.FSKNext;
+					DDS.FSKBitsLeft = DDS.FSKNextBits;
+					DDS.FSKNextBits = 0;
+				}
+				/* Idle line is mark */
+				if (DDS.FSKBitsLeft) {
+					inc = (DDS.FSKShift & 1) ? DDS.FSKMark : DDS.FSKSpace;
+					DDS.FSKShift >>= 1;
+					DDS.FSKBitsLeft--;
+				} else {
+					inc = DDS.FSKMark;
+				}
+				/* Symbol ends when the symbol phase wraps: the fractional
+				 * part carries over, so the average length is exact */
+				DDS.FSKSymbolLeft = (uint32_t)(((1ULL << 32) - DDS.FSKSymbolPhase
+						+ DDS.FSKSymbolInc - 1) / DDS.FSKSymbolInc);
+				DDS.FSKSymbolPhase += DDS.FSKSymbolLeft * DDS.FSKSymbolInc;
+			}
+			if (n > DDS.FSKSymbolLeft) {
+				n = DDS.FSKSymbolLeft;
+			}
+			DDS.FSKSymbolLeft -= n;
+		}
+		for (; n != 0; n--, i++) {
+			s = (DDS_Sine(acc + phase) * (int32_t)amp) >> 15;
+			block[i] = DAC_VALUE((DDS_DAC_MIDSCALE + ((s * 511) >> 15)));
+			acc += inc;
+		}
+	}
+
+	DDS.Accumulator = acc;
+	if (DDS.FSKEnable) {
+		DDS.PhaseInc = inc;
+	}
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+/*********************************************************************//**
+ * @brief 		Initial DDS engine
+ * 					- Fill both DAC DMA blocks
+ * 					- Set up a circular GPDMA linker list on the DAC
+ * 					- Set DAC update rate, DMA and double buffering
+ * 				DAC_Init() and GPDMA_Init() must have been called before.
+ * 				Call DDS_Cmd() to start the output.
+ * @param[in]	DDSCfg	Pointer to a DDS_CFG_Type structure
+ * @return 		ERROR if the DMA channel is enabled before or the sample
+ * 				rate is 0 or needs more than 0xFFFF DAC clocks,
+ * 				SUCCESS if DDS is configured successfully
+ **********************************************************************/
+Status DDS_Init(DDS_CFG_Type *DDSCfg)
+{
+	GPDMA_Channel_CFG_Type GPDMACfg;
+	DAC_CONVERTER_CFG_Type DACCfg;
+	uint32_t control, pclk, ticks;
+
+	/* DAC counter reload is 16 bits, tuning words use the rate it gives */
+	pclk = CLKPWR_GetPCLK(CLKPWR_PCLKSEL_DAC);
+	if ((DDSCfg->SampleRate == 0) || (DDSCfg->SampleRate > pclk)) {
+		return ERROR;
+	}
+	ticks = (pclk + DDSCfg->SampleRate / 2) / DDSCfg->SampleRate;
+	if (ticks > 0xFFFF) {
+		return ERROR;
+	}
+	DDS.DACClock = pclk;
+	DDS.SampleTicks = ticks;
+	DDS.SampleRate = pclk / ticks;
+	DDS.ChannelNum = DDSCfg->ChannelNum;
+	DDS.Accumulator = 0;
+	DDS.PhaseInc = DDS_TuningWord(DDSCfg->Frequency);
+	DDS.Amplitude = DDSCfg->Amplitude;
+	DDS.Phase = DDSCfg->Phase;
+	DDS.PhaseIncPending = 0;
+	DDS.AmplitudePending = 0;
+	DDS.PhasePending = 0;
+	DDS.SweepEnable = DISABLE;
+	DDS.FSKEnable = DISABLE;
+	DDS.FSKSymbolInc = 0;
+	DDS.Active = 0;
+
+	DDS_FillBlock(DDS_Buffer[0]);
+	DDS_FillBlock(DDS_Buffer[1]);
+
+	/* Block 0 -> block 1 -> block 0 ..., interrupt at the end of each block */
+	control = GPDMA_DMACCxControl_TransferSize(DDS_BLOCK_SIZE)
+			| GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_WORD)
+			| GPDMA_DMACCxControl_SI
+			| GPDMA_DMACCxControl_I;
+	DDS_LLI[0].SrcAddr = (uint32_t)DDS_Buffer[1];
+	DDS_LLI[0].DstAddr = (uint32_t)&(LPC_DAC->DACR);
+	DDS_LLI[0].NextLLI = (uint32_t)&DDS_LLI[1];
+	DDS_LLI[0].Control = control;
+	DDS_LLI[1].SrcAddr = (uint32_t)DDS_Buffer[0];
+	DDS_LLI[1].DstAddr = (uint32_t)&(LPC_DAC->DACR);
+	DDS_LLI[1].NextLLI = (uint32_t)&DDS_LLI[0];
+	DDS_LLI[1].Control = control;
+
+	GPDMACfg.ChannelNum = DDSCfg->ChannelNum;
+	GPDMACfg.SrcMemAddr = (uint32_t)DDS_Buffer[0];
+	GPDMACfg.DstMemAddr = 0;
+	GPDMACfg.TransferSize = DDS_BLOCK_SIZE;
+	GPDMACfg.TransferWidth = 0;
+	GPDMACfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	GPDMACfg.SrcConn = 0;
+	GPDMACfg.DstConn = GPDMA_CONN_DAC;
+	GPDMACfg.DMALLI = (uint32_t)&DDS_LLI[0];
+	if (GPDMA_Setup(&GPDMACfg) == ERROR) {
+		return ERROR;
+	}
+
+	DAC_SetDMATimeOut(LPC_DAC, DDS.SampleTicks);
+	DACCfg.DBLBUF_ENA = 1;
+	DACCfg.CNT_ENA = 1;
+	DACCfg.DMA_ENA = 1;
+	DAC_ConfigDAConverterControl(LPC_DAC, &DACCfg);
+
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Start/Stop DDS output
+ * @param[in]	NewState	New State of DDS output, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void DDS_Cmd(FunctionalState NewState)
+{
+	if (NewState == ENABLE) {
+		TRACE_DMA_START(DDS.ChannelNum, DDS_BLOCK_SIZE);
+		GPDMA_STATS_Start(DDS.ChannelNum);
+		GPDMA_ChannelCmd(DDS.ChannelNum, ENABLE);
+	} else {
+		GPDMA_ChannelCmd(DDS.ChannelNum, DISABLE);
+		GPDMA_STATS_Stop(DDS.ChannelNum);
+	}
+}
+
+/*********************************************************************//**
+ * @brief 		Set output frequency, takes effect at next block boundary.
+ * 				Phase is continuous across the change.
+ * @param[in]	freq	Output frequency (Hz), should be < SampleRate/2
+ * @return 		None
+ **********************************************************************/
+void DDS_SetFrequency(uint32_t freq)
+{
+	DDS.NextPhaseInc = DDS_TuningWord(freq);
+	DDS.PhaseIncPending = 1;
+}
+
+/*********************************************************************//**
+ * @brief 		Set output amplitude, takes effect at next block boundary
+ * @param[in]	amplitude	Q15 amplitude, in range from 0 to DDS_AMPLITUDE_FULL
+ * @return 		None
+ **********************************************************************/
+void DDS_SetAmplitude(uint32_t amplitude)
+{
+	DDS.NextAmplitude = amplitude;
+	DDS.AmplitudePending = 1;
+}
+
+/*********************************************************************//**
+ * @brief 		Set output phase offset, takes effect at next block boundary
+ * @param[in]	phase	Phase offset, 0..0xFFFFFFFF maps to 0..360 deg
+ * @return 		None
+ **********************************************************************/
+void DDS_SetPhase(uint32_t phase)
+{
+	DDS.NextPhase = phase;
+	DDS.PhasePending = 1;
+}
+
+/*********************************************************************//**
+ * @brief 		Configure a continuous linear sweep (chirp). The tuning
+ * 				word moves by one step every block and wraps back to the
+ * 				start frequency when it passes the stop frequency.
+ * 				Sweep must be disabled while calling this function.
+ * @param[in]	start	Start frequency (Hz), should be < SampleRate/2
+ * @param[in]	stop	Stop frequency (Hz), should be < SampleRate/2,
+ * 						may be lower than start
+ * @param[in]	step	Frequency step per block (Hz), should be in range
+ * 						from 1 to SampleRate/2 - 1. A downward sweep needs
+ * 						stop >= step so the tuning word cannot wrap below 0.
+ * @return 		ERROR if sweep is enabled or a parameter is out of range,
+ * 				SUCCESS if sweep is configured
+ **********************************************************************/
+Status DDS_SweepConfig(uint32_t start, uint32_t stop, uint32_t step)
+{
+	uint32_t nyquist = DDS.SampleRate / 2;
+	uint32_t startinc, stopinc, stepinc;
+
+	/* Below Nyquist every tuning word is < 2^31: no overflow going up */
+	if (DDS.SweepEnable || (step == 0) || (start >= nyquist) || (stop >= nyquist)
+			|| (step >= nyquist)) {
+		return ERROR;
+	}
+	startinc = DDS_TuningWord(start);
+	stopinc = DDS_TuningWord(stop);
+	stepinc = DDS_TuningWord(step);
+	if ((stop < start) && (stopinc < stepinc)) {
+		return ERROR;
+	}
+	DDS.SweepStart = startinc;
+	DDS.SweepStop = stopinc;
+	DDS.SweepStep = (stop < start) ? -(int32_t)stepinc : (int32_t)stepinc;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Enable/Disable sweep. When enabled, the sweep restarts
+ * 				from the start frequency at next block boundary.
+ * @param[in]	NewState	New State of sweep, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		None
+ **********************************************************************/
+void DDS_SweepCmd(FunctionalState NewState)
+{
+	if (NewState == ENABLE) {
+		DDS.NextPhaseInc = DDS.SweepStart;
+		DDS.PhaseIncPending = 1;
+	}
+	DDS.SweepEnable = NewState;
+}
+
+/*********************************************************************//**
+ * @brief 		Configure binary FSK. Symbols are phase continuous and
+ * 				the line idles on the mark frequency.
+ * 				FSK must be disabled while calling this function.
+ * @param[in]	mark	Frequency for symbol '1' (Hz)
+ * @param[in]	space	Frequency for symbol '0' (Hz)
+ * @param[in]	baudrate	Symbol rate (symbols/s), should be in range from 1
+ * 							to SampleRate - 1. Symbol lengths vary by one
+ * 							sample so that the average rate is exact.
+ * @return 		ERROR if FSK is enabled or baudrate is out of range,
+ * 				SUCCESS if FSK is configured
+ **********************************************************************/
+Status DDS_FSKConfig(uint32_t mark, uint32_t space, uint32_t baudrate)
+{
+	if (DDS.FSKEnable || (baudrate == 0) || (baudrate >= DDS.SampleRate)) {
+		return ERROR;
+	}
+	DDS.FSKMark = DDS_TuningWord(mark);
+	DDS.FSKSpace = DDS_TuningWord(space);
+	DDS.FSKSymbolInc = DDS_TuningWord(baudrate);
+	DDS.FSKSymbolPhase = 0;
+	DDS.FSKSymbolLeft = 0;
+	DDS.FSKBitsLeft = 0;
+	DDS.FSKNextBits = 0;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Enable/Disable FSK. While enabled, sweep is paused and a
+ * 				DDS_SetFrequency() takes effect only once FSK is disabled.
+ * @param[in]	NewState	New State of FSK, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return 		ERROR if enabling before DDS_FSKConfig() succeeded,
+ * 				SUCCESS otherwise
+ **********************************************************************/
+Status DDS_FSKCmd(FunctionalState NewState)
+{
+	if ((NewState == ENABLE) && (DDS.FSKSymbolInc == 0)) {
+		return ERROR;
+	}
+	DDS.FSKEnable = NewState;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		Queue FSK symbols, sent LSB first right after the symbols
+ * 				already being sent
+ * @param[in]	bits	Symbols to send
+ * @param[in]	nbits	Number of symbols in bits, should be 1..32
+ * @return 		ERROR if previous symbols are still queued or nbits is out
+ * 				of range, SUCCESS if symbols are queued
+ **********************************************************************/
+Status DDS_FSKSend(uint32_t bits, uint8_t nbits)
+{
+	if (DDS.FSKNextBits || (nbits == 0) || (nbits > 32)) {
+		return ERROR;
+	}
+	DDS.FSKNext = bits;
+	DDS.FSKNextBits = nbits;
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief 		DDS DMA handler, should be called from DMA_IRQHandler()
+ * 				when the DDS channel has a terminal count interrupt.
+ * 				Refills the block that DMA has just finished.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void DDS_DMAHandler(void)
+{
+	GPDMA_ClearIntPending(GPDMA_STATCLR_INTTC, DDS.ChannelNum);
+	TRACE_DMA_TC(DDS.ChannelNum);
+	GPDMA_STATS_TC(DDS.ChannelNum, DDS_BLOCK_SIZE * 4);
+	DDS_FillBlock(DDS_Buffer[DDS.Active]);
+	DDS.Active ^= 1;
+}
@@ -0,0 +1,207 @@
+/* ########################## profsym — host tool ########################## */
+
+/*
+ * Symbolize a PROFILE_Buffer dump (see "17. PROFILER.c") against the
+ * firmware ELF and print a flat profile, most sampled function first.
+ * "self" counts samples whose PC is in the function, "caller" counts
+ * samples whose stacked LR is in it (exact for leaf callees only).
+ *
+ * Build:	cc -O2 -o profsym tools/profsym.c
+ * Dump:	(gdb) dump binary value prof.bin PROFILE_Buffer
+ * Usage:	profsym firmware.elf prof.bin
+ * 			NM=arm-none-eabi-nm by default, set NM to override
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Private Macros ------------------------------------------------------------- */
+
+#define PROFILE_MAGIC			0x31465250
+#define PROFILE_HEADER_SIZE		16
+#define PROFILE_SAMPLE_SIZE		8
+
+/* Private Types -------------------------------------------------------------- */
+
+typedef struct {
+	uint32_t Addr;
+	char *Name;
+	uint32_t Self;
+	uint32_t Caller;
+} Symbol_Type;
+
+/* Private Variables ---------------------------------------------------------- */
+
+static Symbol_Type *Sym;
+static size_t NumSym;
+static uint32_t Unknown;
+
+/* Private Functions ---------------------------------------------------------- */
+
+static uint32_t GetU32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Read code symbols with "nm -n", sorted by address */
+static int LoadSymbols(const char *elf)
+{
+	const char *nm = getenv("NM");
+	char cmd[1024], line[1024], name[768], type;
+	unsigned long addr;
+	size_t cap = 0;
+	FILE *p;
+
+	/* The path is quoted for the shell, a quote in it would end the quoting */
+	if (strchr(elf, '\'') != NULL) {
+		fprintf(stderr, "%s: quote in ELF path not supported\n", elf);
+		return -1;
+	}
+	snprintf(cmd, sizeof(cmd), "%s -n --defined-only '%s'", nm ? nm : "arm-none-eabi-nm", elf);
+	p = popen(cmd, "r");
+	if (p == NULL) {
+		perror(cmd);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), p) != NULL) {
+		if (sscanf(line, "%lx %c %767s", &addr, &type, name) != 3) {
+			continue;
+		}
+		if ((type != 'T') && (type != 't') && (type != 'W') && (type != 'w')) {
+			continue;
+		}
+		/* Skip ARM mapping symbols $t, $a, $d */
+		if (name[0] == '$') {
+			continue;
+		}
+		if (NumSym == cap) {
+			cap = cap ? cap * 2 : 256;
+			Sym = realloc(Sym, cap * sizeof(Symbol_Type));
+			if (Sym == NULL) {
+				pclose(p);
+				return -1;
+			}
+		}
+		Sym[NumSym].Addr = (uint32_t)addr & ~1u;
+		Sym[NumSym].Name = strdup(name);
+		Sym[NumSym].Self = 0;
+		Sym[NumSym].Caller = 0;
+		NumSym++;
+	}
+	if ((pclose(p) != 0) || (NumSym == 0)) {
+		fprintf(stderr, "%s: no code symbols from '%s'\n", elf, cmd);
+		return -1;
+	}
+	return 0;
+}
+
+/* Last symbol at or below addr, NULL if below the first one */
+static Symbol_Type *FindSymbol(uint32_t addr)
+{
+	size_t lo = 0, hi = NumSym;
+
+	addr &= ~1u;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (Sym[mid].Addr <= addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo ? &Sym[lo - 1] : NULL;
+}
+
+static int BySelf(const void *a, const void *b)
+{
+	const Symbol_Type *x = a, *y = b;
+
+	if (x->Self != y->Self) {
+		return (x->Self < y->Self) ? 1 : -1;
+	}
+	return (x->Caller < y->Caller) ? 1 : (x->Caller > y->Caller) ? -1 : 0;
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+	FILE *f;
+	uint8_t hdr[PROFILE_HEADER_SIZE];
+	uint8_t *samples;
+	uint32_t size, head, divider, count, start, i;
+	Symbol_Type *s;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s firmware.elf prof.bin\n", argv[0]);
+		return 2;
+	}
+	f = fopen(argv[2], "rb");
+	if (f == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+	if ((fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) || (GetU32(hdr) != PROFILE_MAGIC)) {
+		fprintf(stderr, "%s: not a profile dump\n", argv[2]);
+		return 1;
+	}
+	size = GetU32(hdr + 4);
+	head = GetU32(hdr + 8);
+	divider = GetU32(hdr + 12);
+	if ((size == 0) || (size & (size - 1))) {
+		fprintf(stderr, "%s: bad header (size %u)\n", argv[2], size);
+		return 1;
+	}
+	samples = malloc((size_t)size * PROFILE_SAMPLE_SIZE);
+	if ((samples == NULL) || (fread(samples, PROFILE_SAMPLE_SIZE, size, f) != size)) {
+		fprintf(stderr, "%s: truncated dump\n", argv[2]);
+		return 1;
+	}
+	fclose(f);
+
+	if (LoadSymbols(argv[1]) != 0) {
+		return 1;
+	}
+
+	/* Ring has wrapped when head > size, only the last size samples remain */
+	count = (head > size) ? size : head;
+	start = head - count;
+	for (i = 0; i < count; i++) {
+		const uint8_t *p = samples + (size_t)((start + i) & (size - 1)) * PROFILE_SAMPLE_SIZE;
+
+		s = FindSymbol(GetU32(p));
+		if (s != NULL) {
+			s->Self++;
+		} else {
+			Unknown++;
+		}
+		s = FindSymbol(GetU32(p + 4));
+		if (s != NULL) {
+			s->Caller++;
+		}
+	}
+
+	printf("%u samples (%u taken, 1 per %u ticks)\n\n", count, head, divider);
+	if (count == 0) {
+		return 0;
+	}
+	qsort(Sym, NumSym, sizeof(Symbol_Type), BySelf);
+	printf("  %%self     self   caller  function\n");
+	for (i = 0; i < NumSym; i++) {
+		if ((Sym[i].Self == 0) && (Sym[i].Caller == 0)) {
+			continue;
+		}
+		printf("%6.2f %8u %8u  %s\n", 100.0 * Sym[i].Self / count, Sym[i].Self, Sym[i].Caller, Sym[i].Name);
+	}
+	if (Unknown) {
+		printf("%6.2f %8u %8s  <unknown>\n", 100.0 * Unknown / count, Unknown, "");
+	}
+	free(samples);
+
+	return 0;
+}
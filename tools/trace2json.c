@@ -0,0 +1,206 @@
+/* ########################## trace2json — host tool ########################## */
+
+/*
+ * Convert a TRACE_Buffer dump (see "11. TRACE.c") to Chrome trace JSON,
+ * readable by chrome://tracing and ui.perfetto.dev.
+ *
+ * Build:	cc -O2 -o trace2json tools/trace2json.c
+ * Dump:	(gdb) dump binary value trace.bin TRACE_Buffer
+ * Usage:	trace2json trace.bin > trace.json
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Private Macros ------------------------------------------------------------- */
+
+#define TRACE_MAGIC				0x31435254
+#define TRACE_HEADER_SIZE		16
+#define TRACE_EVENT_SIZE		8
+
+#define TRACE_EV_ISR_ENTER		1
+#define TRACE_EV_ISR_EXIT		2
+#define TRACE_EV_DMA_START		3
+#define TRACE_EV_DMA_TC			4
+#define TRACE_EV_DMA_ERR		5
+#define TRACE_EV_ADC_BURST		6
+#define TRACE_EV_TIM_MATCH		7
+#define TRACE_EV_USER			8
+
+/* Private Variables ---------------------------------------------------------- */
+
+/** LPC17xx IRQn names, index is IRQn */
+static const char *const IRQName[] = {
+	"WDT", "TIMER0", "TIMER1", "TIMER2", "TIMER3", "UART0", "UART1", "UART2",
+	"UART3", "PWM1", "I2C0", "I2C1", "I2C2", "SPI", "SSP0", "SSP1",
+	"PLL0", "RTC", "EINT0", "EINT1", "EINT2", "EINT3", "ADC", "BOD",
+	"USB", "CAN", "DMA", "I2S", "ENET", "RIT", "MCPWM", "QEI",
+	"PLL1", "USBActivity", "CANActivity",
+};
+
+/** Cortex-M3 system exceptions, index is -IRQn */
+static const char *const ExcName[] = {
+	"", "SysTick", "PendSV", "", "DebugMonitor", "SVCall", "", "", "", "",
+	"UsageFault", "BusFault", "MemManage", "HardFault", "NonMaskableInt",
+};
+
+/** Match interrupt acknowledged by the ISR, index is TIM_INT_TYPE */
+static const char *const TIMIntName[] = { "MR0 ack", "MR1 ack", "MR2 ack", "MR3 ack" };
+
+static int First = 1;
+
+/* Private Functions ---------------------------------------------------------- */
+
+static uint32_t GetU32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const char *IRQString(uint8_t id)
+{
+	static char buf[16];
+	int irqn = (int8_t)id;
+
+	if ((irqn >= 0) && (irqn < (int)(sizeof(IRQName) / sizeof(IRQName[0])))) {
+		return IRQName[irqn];
+	}
+	if ((irqn < 0) && (-irqn < (int)(sizeof(ExcName) / sizeof(ExcName[0]))) && ExcName[-irqn][0]) {
+		return ExcName[-irqn];
+	}
+	snprintf(buf, sizeof(buf), "IRQ%d", irqn);
+	return buf;
+}
+
+static int TimerNum(uint8_t id)
+{
+	switch (id) {
+	case 0x04: return 0;
+	case 0x08: return 1;
+	case 0x90: return 2;
+	case 0x94: return 3;
+	default: return -1;
+	}
+}
+
+static void Emit(const char *ph, const char *name, const char *tid, double us, const char *args)
+{
+	printf("%s\n{\"ph\":\"%s\",\"name\":\"%s\",\"pid\":1,\"tid\":\"%s\",\"ts\":%.3f%s%s%s}",
+			First ? "" : ",", ph, name, tid, us, args ? ",\"args\":{" : "", args ? args : "", args ? "}" : "");
+	First = 0;
+}
+
+/* Public Functions ----------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+	FILE *f;
+	uint8_t hdr[TRACE_HEADER_SIZE];
+	uint8_t *events;
+	uint32_t size, head, clock, count, start, i, last = 0;
+	int64_t cycles = 0;
+	int dma_open[8] = { 0 };
+	char tid[32], name[32], args[64];
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s trace.bin > trace.json\n", argv[0]);
+		return 2;
+	}
+	f = fopen(argv[1], "rb");
+	if (f == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	if ((fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr)) || (GetU32(hdr) != TRACE_MAGIC)) {
+		fprintf(stderr, "%s: not a trace dump\n", argv[1]);
+		return 1;
+	}
+	size = GetU32(hdr + 4);
+	head = GetU32(hdr + 8);
+	clock = GetU32(hdr + 12);
+	if ((size == 0) || (size & (size - 1)) || (clock == 0)) {
+		fprintf(stderr, "%s: bad header (size %u, clock %u)\n", argv[1], size, clock);
+		return 1;
+	}
+	events = malloc((size_t)size * TRACE_EVENT_SIZE);
+	if ((events == NULL) || (fread(events, TRACE_EVENT_SIZE, size, f) != size)) {
+		fprintf(stderr, "%s: truncated dump\n", argv[1]);
+		return 1;
+	}
+	fclose(f);
+
+	/* Oldest event first; ring has wrapped when head > size */
+	count = (head > size) ? size : head;
+	start = head - count;
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for (i = 0; i < count; i++) {
+		const uint8_t *ev = events + (size_t)((start + i) & (size - 1)) * TRACE_EVENT_SIZE;
+		uint32_t ts = GetU32(ev);
+		uint8_t type = ev[4];
+		uint8_t id = ev[5];
+		uint16_t arg = (uint16_t)(ev[6] | (ev[7] << 8));
+		double us;
+
+		/* Unwrap the 32-bit cycle counter (gaps must stay below 2^31 cycles).
+		 * Small steps back come from a nested interrupt between a slot
+		 * claim and its timestamp */
+		if (i == 0) {
+			cycles = ts;
+		} else if ((int32_t)(ts - last) > 0) {
+			cycles += (uint32_t)(ts - last);
+		} else {
+			cycles -= (uint32_t)(last - ts);
+		}
+		last = ts;
+		us = (double)cycles * 1e6 / clock;
+
+		switch (type) {
+		case TRACE_EV_ISR_ENTER:
+		case TRACE_EV_ISR_EXIT:
+			Emit(type == TRACE_EV_ISR_ENTER ? "B" : "E", IRQString(id), "ISR", us, NULL);
+			break;
+		case TRACE_EV_DMA_START:
+			snprintf(tid, sizeof(tid), "DMA ch%u", id);
+			snprintf(args, sizeof(args), "\"size\":%u", arg);
+			if ((id < 8) && dma_open[id]) {
+				Emit("E", "transfer", tid, us, NULL);
+			}
+			Emit("B", "transfer", tid, us, args);
+			if (id < 8) {
+				dma_open[id] = 1;
+			}
+			break;
+		case TRACE_EV_DMA_TC:
+		case TRACE_EV_DMA_ERR:
+			snprintf(tid, sizeof(tid), "DMA ch%u", id);
+			snprintf(name, sizeof(name), "%s", type == TRACE_EV_DMA_TC ? "terminal count" : "error");
+			Emit("i", name, tid, us, NULL);
+			/* Circular transfers keep running after terminal count */
+			if ((type == TRACE_EV_DMA_ERR) && (id < 8) && dma_open[id]) {
+				Emit("E", "transfer", tid, us, NULL);
+				dma_open[id] = 0;
+			}
+			break;
+		case TRACE_EV_ADC_BURST:
+			Emit(arg ? "B" : "E", "burst", "ADC", us, NULL);
+			break;
+		case TRACE_EV_TIM_MATCH:
+			snprintf(tid, sizeof(tid), "TIMER%d", TimerNum(id));
+			Emit("i", arg < 4 ? TIMIntName[arg] : "INT", tid, us, NULL);
+			break;
+		case TRACE_EV_USER:
+			snprintf(name, sizeof(name), "user%u", id);
+			snprintf(args, sizeof(args), "\"arg\":%u", arg);
+			Emit("i", name, "USER", us, args);
+			break;
+		default:
+			/* Slot claimed but not yet written when dumped */
+			break;
+		}
+	}
+	printf("\n]}\n");
+	free(events);
+
+	return 0;
+}